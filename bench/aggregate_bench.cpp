@@ -0,0 +1,62 @@
+// Custo por leitura da agregação do AGG: leitura a leitura, com busca do
+// intervalo em um std::map (como um cliente faria após um GET), e com o
+// Aggregator, que reduz cada trecho do mesmo intervalo de uma vez.
+//
+// Uso: aggregate_bench [readings] [iterations]
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "aggregate.hpp"
+#include "bench_util.hpp"
+
+static std::size_t aggregate_per_reading(const std::vector<Reading> &readings, std::int64_t bucket_seconds)
+{
+    std::map<std::int64_t, AggBucket> buckets;
+    for (const Reading &reading : readings)
+    {
+        AggBucket &bucket = buckets[reading.timestamp / bucket_seconds * bucket_seconds];
+        bucket.min = std::min(bucket.min, reading.value);
+        bucket.max = std::max(bucket.max, reading.value);
+        bucket.sum += reading.value;
+        bucket.count++;
+        bucket.last = reading.value;
+    }
+    return buckets.size();
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> value(-100, 100);
+    std::vector<Reading> readings(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        readings[i] = Reading{static_cast<std::time_t>(1700000000 + i), value(rng)};
+    }
+
+    for (std::int64_t bucket_seconds : {60, 3600})
+    {
+        std::string suffix = "/" + std::to_string(bucket_seconds);
+        double naive = run_benchmark("BM_AggPerReading" + suffix, iterations, [&](std::size_t)
+                                     { do_not_optimize(aggregate_per_reading(readings, bucket_seconds)); });
+        double chunked = run_benchmark("BM_AggAggregator" + suffix, iterations, [&](std::size_t)
+                                       {
+                                           Aggregator aggregator(bucket_seconds);
+                                           // Trechos de 1024 leituras, como entregues por SensorLog::scan_range
+                                           for (std::size_t i = 0; i < count; i += 1024)
+                                           {
+                                               aggregator.add(readings.data() + i, std::min<std::size_t>(1024, count - i));
+                                           }
+                                           do_not_optimize(aggregator.buckets().data()); });
+        std::printf("bucket %llds: %.2f vs %.2f ns/reading\n", static_cast<long long>(bucket_seconds),
+                    naive / count, chunked / count);
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Utilitários mínimos para os microbenchmarks (saída no estilo Google Benchmark).
+
+// Impede que o compilador descarte um resultado calculado no benchmark
+template <typename T>
+inline void do_not_optimize(const T &value)
+{
+    asm volatile("" : : "g"(value) : "memory");
+}
+
+// Executa fn(iteration) `iterations` vezes e imprime o tempo médio por operação
+template <typename Fn>
+inline double run_benchmark(const std::string &name, std::size_t iterations, Fn &&fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        fn(i);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double ns_per_op = seconds * 1e9 / iterations;
+    std::printf("%-40s %12.1f ns %14zu iterations %14.0f ops/s\n",
+                name.c_str(), ns_per_op, iterations, iterations / seconds);
+    return ns_per_op;
+}
@@ -0,0 +1,169 @@
+// Mede a compressão dos segmentos (gorilla_encode/gorilla_decode): razão em
+// relação aos formatos v1 (48 bytes por leitura) e v2 (16 bytes) e custo de
+// codificação/decodificação por leitura, em blocos como os do servidor.
+//
+// Séries geradas:
+//   emulator: cadência de 1 s e valores uniformes em [-100, 100], como o
+//             sensor_emulator.py (pior caso para o XOR dos valores)
+//   walk:     cadência de 1 s e leitura com resolução de 0,5 que muda em
+//             ~10% das amostras (sensor que varia lentamente)
+//
+// Antes de medir, valida o round trip com intervalos irregulares: os
+// limites de cada faixa do delta-of-delta, saltos grandes e aleatórios.
+//
+// Uso: gorilla_bench [points] [block_points]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "bench_util.hpp"
+#include "gorilla.hpp"
+#include "log_format.hpp"
+
+static std::vector<Reading> emulator_series(std::size_t points)
+{
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> value(-100, 100);
+    std::vector<Reading> readings(points);
+    for (std::size_t i = 0; i < points; ++i)
+    {
+        readings[i] = Reading{static_cast<std::time_t>(1700000000 + i), value(rng)};
+    }
+    return readings;
+}
+
+static std::vector<Reading> walk_series(std::size_t points)
+{
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> step(0, 19);
+    std::vector<Reading> readings(points);
+    int level = 50; // em passos de 0,5
+    for (std::size_t i = 0; i < points; ++i)
+    {
+        int s = step(rng);
+        level += s == 0 ? -1 : s == 1 ? 1 : 0;
+        readings[i] = Reading{static_cast<std::time_t>(1700000000 + i), level * 0.5};
+    }
+    return readings;
+}
+
+// Deltas-of-delta nos limites das faixas de 7, 9 e 12 bits e fora delas
+static bool check_irregular_round_trip()
+{
+    const std::int64_t boundaries[] = {1, 63, 64, 65, 255, 256, 257, 2047, 2048, 2049, 100000, 1LL << 40};
+    std::vector<std::int64_t> dods;
+    for (std::int64_t dod : boundaries)
+    {
+        dods.push_back(dod);
+        dods.push_back(-dod);
+        dods.push_back(0);
+        dods.push_back(-dod);
+        dods.push_back(dod);
+    }
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<std::int64_t> jitter(-5000, 5000);
+    for (int i = 0; i < 10000; ++i)
+    {
+        dods.push_back(jitter(rng));
+    }
+
+    std::vector<Reading> readings;
+    std::int64_t ts = 1700000000;
+    std::int64_t delta = 0;
+    readings.push_back(Reading{static_cast<std::time_t>(ts), 0.0});
+    for (std::int64_t dod : dods)
+    {
+        delta += dod;
+        ts += delta;
+        readings.push_back(Reading{static_cast<std::time_t>(ts), static_cast<double>(readings.size())});
+    }
+
+    std::vector<std::uint8_t> encoded;
+    gorilla_encode(readings.data(), readings.size(), encoded);
+    std::vector<Reading> decoded;
+    gorilla_decode(encoded.data(), encoded.size(), readings.size(), decoded);
+    for (std::size_t i = 0; i < readings.size(); ++i)
+    {
+        if (decoded[i].timestamp != readings[i].timestamp || decoded[i].value != readings[i].value)
+        {
+            std::printf("irregular round trip mismatch at %zu: %lld -> %lld\n", i,
+                        static_cast<long long>(readings[i].timestamp), static_cast<long long>(decoded[i].timestamp));
+            return false;
+        }
+    }
+    std::printf("irregular: %zu points match\n", readings.size());
+    return true;
+}
+
+static void run(const std::string &name, const std::vector<Reading> &readings, std::size_t block_points)
+{
+    const std::size_t points = readings.size();
+    const std::size_t blocks = (points + block_points - 1) / block_points;
+
+    std::vector<std::vector<std::uint8_t>> encoded(blocks);
+    std::size_t bytes = 0;
+    for (std::size_t b = 0; b < blocks; ++b)
+    {
+        std::size_t first = b * block_points;
+        gorilla_encode(readings.data() + first, std::min(block_points, points - first), encoded[b]);
+        bytes += encoded[b].size();
+    }
+
+    std::vector<Reading> decoded;
+    decoded.reserve(points);
+    for (std::size_t b = 0; b < blocks; ++b)
+    {
+        std::size_t first = b * block_points;
+        gorilla_decode(encoded[b].data(), encoded[b].size(), std::min(block_points, points - first), decoded);
+    }
+    if (decoded.size() != points || std::memcmp(decoded.data(), readings.data(), points * sizeof(Reading)) != 0)
+    {
+        std::printf("%s: round trip mismatch\n", name.c_str());
+        std::exit(1);
+    }
+
+    // Inclui o cabeçalho de 24 bytes de cada bloco no arquivo .gts
+    bytes += blocks * 24;
+    std::printf("%s: %.2f bytes/point, ratio %.1fx vs v2 (16 B), %.1fx vs v1 (48 B)\n", name.c_str(),
+                static_cast<double>(bytes) / points,
+                static_cast<double>(points * sizeof(CompactRecord)) / bytes,
+                static_cast<double>(points * sizeof(LogRecord)) / bytes);
+
+    std::vector<std::uint8_t> out;
+    double encode_ns = run_benchmark("BM_GorillaEncode/" + name, blocks, [&](std::size_t b)
+                                     {
+                                         std::size_t first = b * block_points;
+                                         out.clear();
+                                         gorilla_encode(readings.data() + first, std::min(block_points, points - first), out);
+                                         do_not_optimize(out.data()); });
+    double decode_ns = run_benchmark("BM_GorillaDecode/" + name, blocks, [&](std::size_t b)
+                                     {
+                                         std::size_t first = b * block_points;
+                                         decoded.clear();
+                                         gorilla_decode(encoded[b].data(), encoded[b].size(), std::min(block_points, points - first), decoded);
+                                         do_not_optimize(decoded.data()); });
+    std::printf("%s: encode %.2f ns/point, decode %.2f ns/point\n\n", name.c_str(),
+                encode_ns / block_points, decode_ns / block_points);
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t points = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4 << 20;
+    std::size_t block_points = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4096;
+    if (points == 0 || block_points == 0)
+    {
+        std::fprintf(stderr, "Usage: gorilla_bench [points] [block_points]\n");
+        return 1;
+    }
+
+    if (!check_irregular_round_trip())
+    {
+        return 1;
+    }
+    run("emulator", emulator_series(points), block_points);
+    run("walk", walk_series(points), block_points);
+    return 0;
+}
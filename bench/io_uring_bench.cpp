@@ -0,0 +1,90 @@
+// Custo de entregar ao kernel o lote pendente de muitos sensores, como faz
+// a thread de flush a cada janela: um std::ofstream por sensor (write +
+// flush, caminho original do servidor), um write(2) por sensor (backend
+// padrão) e uma única submissão ao io_uring para até 256 sensores
+// (-DDAS_IO_URING=ON). Os lotes são regravados no início de cada arquivo
+// para que o tamanho dos arquivos não cresça com as iterações.
+//
+// Uso: io_uring_bench [sensors] [batch_bytes] [iterations]
+
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "bench_util.hpp"
+#include "io_uring.hpp"
+
+int main(int argc, char *argv[])
+{
+    std::size_t sensors = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    std::size_t batch_bytes = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4096;
+    std::size_t iterations = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 200;
+
+    char dir[] = "/tmp/das_bench_XXXXXX";
+    if (!mkdtemp(dir) || chdir(dir) != 0)
+    {
+        std::perror("mkdtemp");
+        return 1;
+    }
+
+    IoUring ring;
+    if (!ring.is_open())
+    {
+        std::printf("io_uring unavailable: %s\n", std::strerror(ring.error()));
+        std::filesystem::remove_all(dir);
+        return 1;
+    }
+
+    std::vector<int> fds;
+    std::vector<std::unique_ptr<std::ofstream>> streams;
+    for (std::size_t i = 0; i < sensors; ++i)
+    {
+        const std::string name = "sensor_" + std::to_string(i);
+        fds.push_back(::open((name + ".log").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+        streams.push_back(std::make_unique<std::ofstream>(name + ".ofs", std::ios::binary));
+    }
+    std::vector<char> batch(batch_bytes, 'x');
+
+    std::string suffix = "/" + std::to_string(sensors);
+    double ofstream_ns = run_benchmark("BM_FlushOfstream" + suffix, iterations, [&](std::size_t)
+                                       {
+                                           for (auto &stream : streams)
+                                           {
+                                               stream->seekp(0);
+                                               stream->write(batch.data(), static_cast<std::streamsize>(batch.size()));
+                                               stream->flush();
+                                           } });
+    double write_ns = run_benchmark("BM_FlushWrite" + suffix, iterations, [&](std::size_t)
+                                    {
+                                        for (int fd : fds)
+                                        {
+                                            do_not_optimize(::pwrite(fd, batch.data(), batch.size(), 0));
+                                        } });
+    double ring_ns = run_benchmark("BM_FlushIoUring" + suffix, iterations, [&](std::size_t)
+                                   {
+                                       std::size_t next = 0;
+                                       while (next < fds.size())
+                                       {
+                                           for (unsigned n = 0; n < ring.capacity() && next < fds.size(); ++n, ++next)
+                                           {
+                                               ring.prepare_write(fds[next], batch.data(), batch.size(), 0, next);
+                                           }
+                                           ring.submit_and_wait([](std::uint64_t, int result)
+                                                                { do_not_optimize(result); });
+                                       } });
+    std::printf("%.0f / %.0f / %.0f ns per sensor (ofstream / write / io_uring)\n", ofstream_ns / sensors,
+                write_ns / sensors, ring_ns / sensors);
+
+    for (int fd : fds)
+    {
+        ::close(fd);
+    }
+    streams.clear();
+    std::filesystem::remove_all(dir);
+    return 0;
+}
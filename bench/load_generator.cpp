@@ -0,0 +1,211 @@
+// Gerador de carga para o servidor das: abre várias conexões simultâneas,
+// envia mensagens LOG em pipeline e mede as mensagens/s atendidas.
+//
+// Uso: load_generator [--host=H] [--port=P] [--connections=C] [--messages=M] [--batch=B] [--binary]
+//
+// Cada conexão termina com um GET|...|1 e aguarda a resposta, garantindo que
+// todas as mensagens LOG anteriores daquela conexão já foram processadas.
+// Com --batch=B as leituras são enviadas em mensagens LOGB de B leituras.
+// Com --binary as leituras são enviadas no protocolo binário, em quadros de
+// 1000 leituras, e a conexão termina com um quadro vazio de confirmação.
+
+#include <boost/asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "binary_protocol.hpp"
+
+using boost::asio::ip::tcp;
+
+struct LoadOptions
+{
+    std::string host = "127.0.0.1";
+    std::string port = "9000";
+    std::size_t connections = 8;
+    std::size_t messages = 100000; // por conexão
+    std::string prefix = "bench";
+    std::size_t batch = 1; // leituras por mensagem LOGB (1 = mensagens LOG)
+    bool binary = false;
+};
+
+static LoadOptions parse_load_options(int argc, char *argv[])
+{
+    LoadOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        std::size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+        if (name == "--host")
+            options.host = value;
+        else if (name == "--port")
+            options.port = value;
+        else if (name == "--connections")
+            options.connections = std::stoul(value);
+        else if (name == "--messages")
+            options.messages = std::stoul(value);
+        else if (name == "--prefix")
+            options.prefix = value;
+        else if (name == "--batch")
+            options.batch = std::stoul(value);
+        else if (name == "--binary")
+            options.binary = true;
+        else
+            throw std::invalid_argument("Unknown option: " + arg);
+    }
+    return options;
+}
+
+// Com batch > 1 as leituras são agrupadas em mensagens LOGB de até batch leituras
+static std::string build_chunk(const std::string &sensor_id, std::size_t count, std::size_t batch)
+{
+    std::string chunk;
+    char line[128];
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        int len;
+        if (batch <= 1)
+        {
+            len = std::snprintf(line, sizeof(line), "LOG|%s|2023-05-11T15:%02zu:%02zu|%zu.5\r\n",
+                                sensor_id.c_str(), (i / 60) % 60, i % 60, i % 1000);
+        }
+        else
+        {
+            if (i % batch == 0)
+            {
+                len = std::snprintf(line, sizeof(line), "LOGB|%s|%zu", sensor_id.c_str(), std::min(batch, count - i));
+                chunk.append(line, len);
+            }
+            len = std::snprintf(line, sizeof(line), ";2023-05-11T15:%02zu:%02zu|%zu.5%s",
+                                (i / 60) % 60, i % 60, i % 1000, (i + 1) % batch == 0 || i + 1 == count ? "\r\n" : "");
+        }
+        chunk.append(line, len);
+    }
+    return chunk;
+}
+
+// Mesmas leituras de build_chunk, já em quadros binários de até 1000 leituras
+static std::string build_binary_chunk(std::size_t count)
+{
+    const std::time_t base = 1683817200; // 2023-05-11T15:00:00Z
+    std::vector<Reading> readings(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        readings[i] = Reading{base + static_cast<std::time_t>(i % 3600), static_cast<double>(i % 1000) + 0.5};
+    }
+    std::string chunk;
+    append_binary_frame(readings.data(), count, chunk);
+    return chunk;
+}
+
+static void run_binary_connection(tcp::socket &socket, const std::string &sensor_id, std::size_t messages)
+{
+    const std::size_t chunk_messages = 1000;
+    const std::string chunk = build_binary_chunk(chunk_messages);
+    boost::asio::write(socket, boost::asio::buffer(encode_binary_hello(sensor_id)));
+
+    std::size_t remaining = messages;
+    while (remaining > 0)
+    {
+        std::size_t n = std::min(remaining, chunk_messages);
+        if (n == chunk_messages)
+            boost::asio::write(socket, boost::asio::buffer(chunk));
+        else
+            boost::asio::write(socket, boost::asio::buffer(build_binary_chunk(n)));
+        remaining -= n;
+    }
+
+    std::string ack_request;
+    append_binary_frame(nullptr, 0, ack_request);
+    boost::asio::write(socket, boost::asio::buffer(ack_request));
+    char ack[8];
+    boost::asio::read(socket, boost::asio::buffer(ack));
+    if (load_le64(ack) != messages)
+    {
+        throw std::runtime_error("server acknowledged " + std::to_string(load_le64(ack)) + " readings");
+    }
+}
+
+static void run_connection(const LoadOptions &options, std::size_t index, std::atomic<std::size_t> &sent)
+{
+    boost::asio::io_context io_context;
+    tcp::resolver resolver(io_context);
+    tcp::socket socket(io_context);
+    boost::asio::connect(socket, resolver.resolve(options.host, options.port));
+    socket.set_option(tcp::no_delay(true));
+
+    const std::string sensor_id = options.prefix + "_" + std::to_string(index);
+    if (options.binary)
+    {
+        run_binary_connection(socket, sensor_id, options.messages);
+        sent += options.messages;
+        return;
+    }
+
+    const std::size_t chunk_messages = 1000;
+    const std::string chunk = build_chunk(sensor_id, chunk_messages, options.batch);
+
+    std::size_t remaining = options.messages;
+    while (remaining > 0)
+    {
+        std::size_t n = std::min(remaining, chunk_messages);
+        if (n == chunk_messages)
+            boost::asio::write(socket, boost::asio::buffer(chunk));
+        else
+            boost::asio::write(socket, boost::asio::buffer(build_chunk(sensor_id, n, options.batch)));
+        remaining -= n;
+    }
+    sent += options.messages;
+
+    std::string request = "GET|" + sensor_id + "|1\r\n";
+    boost::asio::write(socket, boost::asio::buffer(request));
+    boost::asio::streambuf response;
+    boost::asio::read_until(socket, response, "\r\n");
+}
+
+int main(int argc, char *argv[])
+{
+    LoadOptions options;
+    try
+    {
+        options = parse_load_options(argc, argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << "\n";
+        std::cerr << "Usage: load_generator [--host=H] [--port=P] [--connections=C] [--messages=M] [--prefix=S] [--batch=B] [--binary]\n";
+        return 1;
+    }
+
+    std::atomic<std::size_t> sent{0};
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < options.connections; ++i)
+    {
+        threads.emplace_back([&options, i, &sent]
+                             {
+                                 try
+                                 {
+                                     run_connection(options, i, sent);
+                                 }
+                                 catch (const std::exception &e)
+                                 {
+                                     std::cerr << "connection " << i << ": " << e.what() << "\n";
+                                 } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("connections=%zu messages=%zu seconds=%.3f msgs_per_sec=%.0f\n",
+                options.connections, sent.load(), seconds, sent.load() / seconds);
+    return 0;
+}
@@ -0,0 +1,180 @@
+// Microbenchmark de contenção: T threads escrevendo em sensores distintos,
+// comparando o mapa global protegido por um único mutex (implementação
+// anterior do servidor) com o LogStore particionado. Antes, verifica que
+// leituras gravadas durante compactações do WAL sobrevivem a uma queda.
+//
+// Uso: log_store_contention [records_per_thread] [max_threads]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <unordered_map>
+#include <vector>
+#include "log_store.hpp"
+
+// Caminho de escrita original: um mutex para busca, abertura, escrita e flush
+class GlobalLogMap
+{
+public:
+    void append(const std::string &sensor_id, const LogRecord &record)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (logs_.find(sensor_id) == logs_.end())
+        {
+            logs_[sensor_id].open(sensor_id + ".log", std::ios::binary | std::ios::app);
+        }
+        logs_[sensor_id].write(reinterpret_cast<const char *>(&record), sizeof(record));
+        logs_[sensor_id].flush();
+    }
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::ofstream> logs_;
+};
+
+template <typename AppendFn>
+static double run(std::size_t threads, std::size_t records, const std::string &prefix, AppendFn append)
+{
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]
+                             {
+                                 std::string sensor_id = prefix + std::to_string(t);
+                                 LogRecord record{};
+                                 std::strncpy(record.sensor_id, sensor_id.c_str(), sizeof(record.sensor_id) - 1);
+                                 for (std::size_t i = 0; i < records; ++i)
+                                 {
+                                     record.timestamp = static_cast<std::time_t>(i);
+                                     record.value = static_cast<double>(i);
+                                     append(sensor_id, record);
+                                 } });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return threads * records / seconds;
+}
+
+// Um processo filho grava com várias threads usando um WAL pequeno, que é
+// compactado muitas vezes durante as escritas, e termina sem encerrar o
+// LogStore, como numa queda. Uma leitura já entregue ao kernel no WAL foi
+// aceita, assim como todas as anteriores do mesmo sensor: ao reabrir, cada
+// sensor deve ter ao menos as leituras até a última presente nos WALs.
+static bool check_wal_compaction(std::size_t threads, std::size_t records)
+{
+    const std::time_t start = 1700000000;
+    StoreOptions options;
+    options.storage = StorageEngine::wal;
+    options.flush_window = std::chrono::milliseconds(1);
+    options.wal_bytes = 4096; // uma compactação a cada ciclo da thread de flush
+
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        LogStore *store = new LogStore(options); // nunca destruído
+        run(threads, records, "w", [&](const std::string &id, const LogRecord &r)
+            { store->append(id, Reading{start + r.timestamp, r.value}); });
+        std::printf("wal compactions: %llu\n", static_cast<unsigned long long>(store->stats().wal_compactions));
+        std::fflush(stdout);
+        ::_exit(0);
+    }
+    int status = 0;
+    if (pid < 0 || ::waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        std::fprintf(stderr, "WAL compaction writer failed\n");
+        return false;
+    }
+
+    std::unordered_map<std::uint32_t, std::uint64_t> accepted; // handle -> leituras aceitas
+    for (const std::string &file : WriteAheadLog::existing_files())
+    {
+        WriteAheadLog::replay(file, [&](const WalRecord &record)
+                              {
+                                  std::uint64_t &count = accepted[record.sensor];
+                                  count = std::max(count, record.sequence + 1); });
+    }
+    std::unordered_map<std::string, std::uint64_t> expected;
+    {
+        SensorCatalog catalog;
+        if (!catalog.open(options.catalog_path))
+        {
+            return false;
+        }
+        for (const SensorCatalog::Sensor &sensor : catalog.sensors())
+        {
+            expected[sensor.sensor_id] = accepted[sensor.handle];
+        }
+    }
+
+    LogStore store(options);
+    std::vector<Reading> readings;
+    for (std::size_t t = 0; t < threads; ++t)
+    {
+        const std::string sensor_id = "w" + std::to_string(t);
+        SensorLog *log = store.find(sensor_id);
+        bool ok = log && store.read_last(*log, records, readings) && readings.size() >= expected[sensor_id];
+        for (std::size_t i = 0; ok && i < readings.size(); ++i)
+        {
+            ok = readings[i].timestamp == start + static_cast<std::time_t>(i) && readings[i].value == static_cast<double>(i);
+        }
+        if (!ok)
+        {
+            std::fprintf(stderr, "sensor %s: %zu readings after WAL replay, expected at least %llu\n",
+                         sensor_id.c_str(), readings.size(), static_cast<unsigned long long>(expected[sensor_id]));
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t records = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    std::size_t max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8;
+
+    char dir[] = "/tmp/das_bench_XXXXXX";
+    if (!mkdtemp(dir) || chdir(dir) != 0)
+    {
+        std::perror("mkdtemp");
+        return 1;
+    }
+
+    std::filesystem::create_directory("wal");
+    bool wal_ok = chdir("wal") == 0 && check_wal_compaction(max_threads, records) && chdir(dir) == 0;
+    if (!wal_ok)
+    {
+        std::filesystem::remove_all(dir);
+        return 1;
+    }
+
+    std::printf("%-8s %18s %18s\n", "threads", "global_mutex/s", "sharded/s");
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        GlobalLogMap global;
+        double global_rate = run(threads, records, "g" + std::to_string(threads) + "_",
+                                 [&](const std::string &id, const LogRecord &r)
+                                 { global.append(id, r); });
+
+        LogStore store;
+        double sharded_rate = run(threads, records, "s" + std::to_string(threads) + "_",
+                                  [&](const std::string &id, const LogRecord &r)
+                                  { store.append(id, Reading{r.timestamp, r.value}); });
+
+        std::printf("%-8zu %18.0f %18.0f\n", threads, global_rate, sharded_rate);
+    }
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,62 @@
+// Compara a tokenização original de mensagens LOG (std::getline sobre o
+// streambuf + split_message com std::istringstream) com o parser sobre
+// std::string_view de protocol.hpp.
+//
+// Uso: parser_bench [iterations]
+
+#include <boost/asio.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "bench_util.hpp"
+#include "protocol.hpp"
+
+static std::vector<std::string> split_message(const std::string &message)
+{
+    std::vector<std::string> parts;
+    std::istringstream stream(message);
+    std::string part;
+    while (std::getline(stream, part, '|'))
+    {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+// Simula a chegada de uma linha no buffer de recepção
+static void fill(boost::asio::streambuf &buffer, const std::string &line)
+{
+    auto prepared = buffer.prepare(line.size());
+    std::memcpy(prepared.data(), line.data(), line.size());
+    buffer.commit(line.size());
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    const std::string line = "LOG|sensor_temperature_042|2023-05-11T15:30:00.123456|78.53125\r\n";
+
+    boost::asio::streambuf buffer;
+    run_benchmark("BM_GetlineSplitMessage", iterations, [&](std::size_t)
+                  {
+                      fill(buffer, line);
+                      std::istream is(&buffer);
+                      std::string message;
+                      std::getline(is, message);
+                      auto parts = split_message(message);
+                      do_not_optimize(parts); });
+
+    run_benchmark("BM_StringViewParser", iterations, [&](std::size_t)
+                  {
+                      fill(buffer, line);
+                      std::string_view view(static_cast<const char *>(buffer.data().data()), line.size());
+                      LogMessage message;
+                      bool ok = parse_log_message(strip_line_ending(view), message);
+                      do_not_optimize(ok);
+                      do_not_optimize(message);
+                      buffer.consume(line.size()); });
+    return 0;
+}
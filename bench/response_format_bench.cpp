@@ -0,0 +1,104 @@
+// Formatação de respostas GET de 10.000 registros: std::ostringstream com
+// time_t_to_string por registro (caminho original) e ResponseWriter com
+// std::to_chars e o TimestampFormatter (deslocamento do fuso em cache por
+// hora, sem localtime). Antes de medir, valida que as duas produzem o mesmo
+// texto em fusos com horário de verão.
+//
+// Uso: response_format_bench [records] [iterations]
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "bench_util.hpp"
+#include "log_record.hpp"
+#include "response_writer.hpp"
+
+static std::string time_t_to_string(std::time_t time)
+{
+    std::tm tm = {};
+    localtime_r(&time, &tm);
+    std::ostringstream ss;
+    ss << std::put_time(&tm, "%Y-%m-%dT%H:%M:%S");
+    return ss.str();
+}
+
+static std::string format_with_ostream(const std::vector<Reading> &readings)
+{
+    std::ostringstream response;
+    response << readings.size();
+    for (const Reading &reading : readings)
+    {
+        response << ";" << time_t_to_string(reading.timestamp) << "|" << reading.value;
+    }
+    response << "\r\n";
+    return response.str();
+}
+
+static std::string format_with_writer(const std::vector<Reading> &readings, TimestampFormatter &formatter)
+{
+    ResponseWriter response(24 + readings.size() * 32);
+    response.append_count(readings.size());
+    for (const Reading &reading : readings)
+    {
+        response.append(';');
+        response.append_timestamp(reading.timestamp, formatter);
+        response.append('|');
+        response.append_value(reading.value);
+    }
+    response.append("\r\n");
+    return response.take();
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t records = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    std::size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200;
+
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> value(-100, 100);
+
+    // Validação: leituras a cada 7 s ao longo de dois anos, atravessando as
+    // mudanças de horário, e valores com diferentes ordens de grandeza
+    for (const char *tz : {"UTC", "America/New_York", "America/Sao_Paulo", "Australia/Lord_Howe"})
+    {
+        setenv("TZ", tz, 1);
+        tzset();
+        TimeZone::reset_local_cache();
+        std::vector<Reading> readings;
+        for (std::time_t t = 1300000000; t < 1300000000 + 2 * 365 * 86400; t += 7)
+        {
+            double v = value(rng);
+            readings.push_back(Reading{t, readings.size() % 3 == 0 ? v * 1e7 : v});
+        }
+        TimestampFormatter formatter;
+        if (format_with_ostream(readings) != format_with_writer(readings, formatter))
+        {
+            std::printf("mismatch in TZ=%s\n", tz);
+            return 1;
+        }
+        std::printf("TZ=%s: %zu records match\n", tz, readings.size());
+    }
+
+    setenv("TZ", "America/Sao_Paulo", 1);
+    tzset();
+    TimeZone::reset_local_cache();
+    std::vector<Reading> readings(records);
+    for (std::size_t i = 0; i < records; ++i)
+    {
+        readings[i] = Reading{static_cast<std::time_t>(1700000000 + i), value(rng)};
+    }
+
+    std::string suffix = "/" + std::to_string(records);
+    double before = run_benchmark("BM_FormatOstringstream" + suffix, iterations, [&](std::size_t)
+                                  { do_not_optimize(format_with_ostream(readings).size()); });
+    TimestampFormatter formatter;
+    double after = run_benchmark("BM_FormatResponseWriter" + suffix, iterations, [&](std::size_t)
+                                 { do_not_optimize(format_with_writer(readings, formatter).size()); });
+    std::printf("%.1f vs %.1f ns/record\n", before / records, after / records);
+    return 0;
+}
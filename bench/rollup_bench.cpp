@@ -0,0 +1,73 @@
+// Consultas AGG de janela longa sobre leituras de 1 Hz com e sem os agregados
+// pré-calculados (--rollups), e o custo que mantê-los acrescenta à gravação.
+//
+// Uso: rollup_bench [records] [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "bench_util.hpp"
+#include "log_store.hpp"
+
+static double fill(LogStore &store, SensorLog &log, std::size_t records, std::time_t start)
+{
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < records; ++i)
+    {
+        store.append(log, Reading{start + static_cast<std::time_t>(i), static_cast<double>(i % 1000) * 0.1});
+    }
+    log.flush();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / records;
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t records = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000000;
+    std::size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+
+    char dir[] = "/tmp/das_bench_XXXXXX";
+    if (!mkdtemp(dir) || chdir(dir) != 0)
+    {
+        std::perror("mkdtemp");
+        return 1;
+    }
+
+    const std::time_t start = 1704067200; // 2024-01-01T00:00:00Z
+    StoreOptions options;
+    options.batch_bytes = 1 << 16;
+    LogStore raw_store(options);
+    options.rollups = true;
+    LogStore rollup_store(options);
+    SensorLog &raw = raw_store.get_or_create("raw");
+    SensorLog &rolled = rollup_store.get_or_create("rolled");
+
+    std::printf("append without rollups: %.1f ns/record\n", fill(raw_store, raw, records, start));
+    std::printf("append with rollups:    %.1f ns/record\n\n", fill(rollup_store, rolled, records, start));
+
+    const std::time_t end = start + static_cast<std::time_t>(records) - 1;
+    for (const char *bucket : {"1h", "1d"})
+    {
+        std::int64_t bucket_seconds = 0;
+        parse_bucket_seconds(bucket, bucket_seconds);
+        std::size_t buckets = 0;
+        std::string suffix = std::string("/") + bucket;
+        run_benchmark("BM_AggReadings" + suffix, iterations, [&](std::size_t)
+                      {
+                          Aggregator aggregator(bucket_seconds);
+                          raw_store.aggregate(raw, start, end, aggregator);
+                          buckets = aggregator.buckets().size(); });
+        run_benchmark("BM_AggRollups" + suffix, iterations, [&](std::size_t)
+                      {
+                          Aggregator aggregator(bucket_seconds);
+                          rollup_store.aggregate(rolled, start, end, aggregator);
+                          do_not_optimize(aggregator.buckets().data()); });
+        std::printf("%zu buckets over %zu records\n", buckets, records);
+    }
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,55 @@
+// Custo de localizar o sensor de uma mensagem LOG: busca pelo id no
+// registro de sensores (hash do id e lock compartilhado do shard) e o handle
+// guardado pela sessão (comparação do id e leitura da tabela de handles).
+//
+// Uso: sensor_lookup_bench [sensors] [iterations]
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "bench_util.hpp"
+#include "log_store.hpp"
+
+int main(int argc, char *argv[])
+{
+    std::size_t sensors = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    std::size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20000000;
+
+    char dir[] = "/tmp/das_bench_XXXXXX";
+    if (!mkdtemp(dir) || chdir(dir) != 0)
+    {
+        std::perror("mkdtemp");
+        return 1;
+    }
+
+    LogStore store;
+    std::vector<std::string> ids;
+    for (std::size_t i = 0; i < sensors; ++i)
+    {
+        ids.push_back("SENSOR_" + std::to_string(100000 + i));
+        store.get_or_create(ids.back());
+    }
+
+    // Como em uma conexão por sensor: várias mensagens seguidas do mesmo id
+    const std::string &id = ids[sensors / 2];
+    run_benchmark("BM_GetOrCreate", iterations, [&](std::size_t)
+                  { do_not_optimize(&store.get_or_create(id)); });
+
+    std::string cached_id = id;
+    std::uint32_t cached_handle = store.intern(id);
+    run_benchmark("BM_CachedHandle", iterations, [&](std::size_t)
+                  {
+                      std::string_view message_id = id;
+                      if (message_id != cached_id)
+                      {
+                          cached_handle = store.intern(message_id);
+                          cached_id.assign(message_id.data(), message_id.size());
+                      }
+                      do_not_optimize(&store.at(cached_handle)); });
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
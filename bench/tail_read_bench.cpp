@@ -0,0 +1,85 @@
+// Compara a leitura dos últimos N registros de um sensor com std::ifstream
+// (open + seek + uma leitura de 48 bytes por registro, caminho original do
+// GET), com o arquivo mapeado em memória e com o cache de leituras recentes.
+//
+// Uso: tail_read_bench [records_in_file] [iterations]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "bench_util.hpp"
+#include "log_store.hpp"
+
+static std::size_t read_with_ifstream(const std::string &path, int num_records)
+{
+    std::ifstream log_file(path, std::ios::binary);
+    log_file.seekg(0, std::ios::end);
+    int total_records = log_file.tellg() / sizeof(LogRecord);
+    num_records = std::min(num_records, total_records);
+    log_file.seekg(-num_records * sizeof(LogRecord), std::ios::end);
+
+    double sum = 0;
+    for (int i = 0; i < num_records; ++i)
+    {
+        LogRecord record;
+        log_file.read(reinterpret_cast<char *>(&record), sizeof(record));
+        sum += record.value;
+    }
+    do_not_optimize(sum);
+    return num_records;
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t records_in_file = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    std::size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20000;
+
+    char dir[] = "/tmp/das_bench_XXXXXX";
+    if (!mkdtemp(dir) || chdir(dir) != 0)
+    {
+        std::perror("mkdtemp");
+        return 1;
+    }
+
+    {
+        // Arquivo v1, o único formato que o caminho com std::ifstream entende
+        StoreOptions v1_options;
+        v1_options.format = LogFormat::v1;
+        LogStore store(v1_options);
+        for (std::size_t i = 0; i < records_in_file; ++i)
+        {
+            store.append("tail", Reading{static_cast<std::time_t>(i), static_cast<double>(i)});
+        }
+    }
+
+    // Sem cache: toda consulta lê do arquivo mapeado
+    StoreOptions uncached_options;
+    uncached_options.cache_records = 0;
+    LogStore uncached(uncached_options);
+    LogStore cached;
+
+    for (int n : {10, 100, 1000})
+    {
+        std::string suffix = "/" + std::to_string(n);
+        run_benchmark("BM_IfstreamTail" + suffix, iterations, [&](std::size_t)
+                      { do_not_optimize(read_with_ifstream("tail.log", n)); });
+
+        std::vector<Reading> readings;
+        run_benchmark("BM_MappedTail" + suffix, iterations, [&](std::size_t)
+                      {
+                          uncached.read_last(uncached.get_or_create("tail"), n, readings);
+                          do_not_optimize(readings.data()); });
+        run_benchmark("BM_CachedTail" + suffix, iterations, [&](std::size_t)
+                      {
+                          cached.read_last(cached.get_or_create("tail"), n, readings);
+                          do_not_optimize(readings.data()); });
+    }
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
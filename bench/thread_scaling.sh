@@ -0,0 +1,33 @@
+#!/usr/bin/env bash
+# Mede mensagens LOG/s do servidor das em função do número de threads.
+#
+# Uso: bench/thread_scaling.sh <build_dir> [threads...]
+# Ex.: bench/thread_scaling.sh build 1 2 4 8
+#
+# Variáveis: PORT (9100), CONNECTIONS (64), MESSAGES (20000 por conexão),
+#            DAS_ARGS (opções extras para o servidor, ex. --reuseport)
+set -euo pipefail
+
+BUILD_DIR=${1:?usage: $0 <build_dir> [threads...]}
+shift
+THREADS=${*:-1 2 4 8}
+PORT=${PORT:-9100}
+CONNECTIONS=${CONNECTIONS:-64}
+MESSAGES=${MESSAGES:-20000}
+DAS_ARGS=${DAS_ARGS:-}
+
+DAS=$(realpath "$BUILD_DIR/das")
+LOADGEN=$(realpath "$BUILD_DIR/bench/load_generator")
+WORKDIR=$(mktemp -d)
+trap 'rm -rf "$WORKDIR"' EXIT
+
+printf "%-8s %s\n" threads result
+for t in $THREADS; do
+    (cd "$WORKDIR" && exec "$DAS" "$PORT" --threads="$t" $DAS_ARGS) &
+    pid=$!
+    sleep 0.5
+    result=$("$LOADGEN" --port="$PORT" --connections="$CONNECTIONS" --messages="$MESSAGES" --prefix="t$t")
+    kill "$pid"
+    wait "$pid" 2>/dev/null || true
+    printf "%-8s %s\n" "$t" "$result"
+done
@@ -0,0 +1,212 @@
+// Valida parse_iso8601 contra a conversão original (std::get_time + std::mktime)
+// em milhões de datas aleatórias, verifica que datas malformadas são
+// rejeitadas e compara o custo das duas implementações.
+//
+// Uso: timestamp_bench [validation_samples] [iterations]
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "bench_util.hpp"
+#include "time_codec.hpp"
+#include "time_zone.hpp"
+
+// Implementação original de Session::string_to_time_t
+static std::time_t string_to_time_t(const std::string &time_string)
+{
+    std::tm tm = {};
+    std::istringstream ss(time_string);
+    if (!(ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S")))
+    {
+        return static_cast<std::time_t>(-1);
+    }
+    return std::mktime(&tm);
+}
+
+static std::vector<std::string> random_timestamps(std::size_t count, bool with_fraction)
+{
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> year(1971, 2099), month(1, 12), day(1, 31), hour(0, 23), minsec(0, 59), micros(0, 999999);
+    std::vector<std::string> timestamps;
+    timestamps.reserve(count);
+    char text[40];
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        int len = std::snprintf(text, sizeof(text), "%04d-%02d-%02dT%02d:%02d:%02d",
+                                year(rng), month(rng), day(rng), hour(rng), minsec(rng), minsec(rng));
+        if (with_fraction)
+        {
+            std::snprintf(text + len, sizeof(text) - len, ".%06d", micros(rng));
+        }
+        timestamps.emplace_back(text);
+    }
+    return timestamps;
+}
+
+// Compara com o caminho original sob um TZ sem horário de verão
+static bool validate(const char *tz, long utc_offset, std::size_t samples)
+{
+    setenv("TZ", tz, 1);
+    tzset();
+
+    std::size_t mismatches = 0;
+    for (const std::string &timestamp : random_timestamps(samples, false))
+    {
+        std::time_t expected = string_to_time_t(timestamp);
+        std::time_t actual = 0;
+        if (!parse_iso8601(timestamp, actual, utc_offset) || actual != expected)
+        {
+            if (++mismatches <= 5)
+            {
+                std::printf("mismatch TZ=%s %s: expected %lld got %lld\n", tz, timestamp.c_str(),
+                            static_cast<long long>(expected), static_cast<long long>(actual));
+            }
+        }
+    }
+    std::printf("validation TZ=%-6s %zu samples, %zu mismatches\n", tz, samples, mismatches);
+    return mismatches == 0;
+}
+
+static std::string format_local(std::time_t time)
+{
+    std::tm tm = {};
+    localtime_r(&time, &tm);
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &tm);
+    return text;
+}
+
+// Sob um TZ com horário de verão, a data lida com TimeZone::local() deve
+// corresponder à mesma hora de relógio em localtime_r. Horas inexistentes
+// (adiantamento do relógio) não têm correspondência e são ignoradas.
+static bool validate_local(const char *tz, std::size_t samples)
+{
+    setenv("TZ", tz, 1);
+    tzset();
+    TimeZone::reset_local_cache();
+
+    std::size_t mismatches = 0;
+    std::size_t skipped = 0;
+    for (const std::string &timestamp : random_timestamps(samples, false))
+    {
+        std::time_t actual = 0;
+        if (!parse_iso8601(timestamp, actual, TimeZone::local()))
+        {
+            ++mismatches;
+            continue;
+        }
+        if (format_local(actual) == timestamp)
+        {
+            continue;
+        }
+        std::tm tm = {};
+        std::istringstream(timestamp) >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
+        tm.tm_isdst = -1;
+        if (tm.tm_mday != std::stoi(timestamp.substr(8, 2)) || format_local(std::mktime(&tm)) != timestamp)
+        {
+            ++skipped; // dia inexistente no mês ou hora inexistente no fuso
+            continue;
+        }
+        if (++mismatches <= 5)
+        {
+            std::printf("mismatch TZ=%s %s: got %s\n", tz, timestamp.c_str(), format_local(actual).c_str());
+        }
+    }
+    std::printf("validation TZ=%s (local) %zu samples, %zu skipped, %zu mismatches\n", tz, samples, skipped, mismatches);
+    return mismatches == 0;
+}
+
+// Datas malformadas devem ser rejeitadas, inclusive cada data válida
+// truncada em qualquer posição ou com um dígito trocado por outro caractere
+static bool validate_malformed()
+{
+    std::vector<std::string> malformed = {
+        "", "2024", "2024-03-10", "2024-03-10T12:00", "2024-03-10T12:00:0", "2024-03-10 12:00:00",
+        "2024/03/10T12:00:00", "2024-03-10T12-00-00", "2024-13-10T12:00:00", "2024-00-10T12:00:00",
+        "2024-03-00T12:00:00", "2024-03-32T12:00:00", "2024-03-10T24:00:00", "2024-03-10T12:60:00",
+        "2024-03-10T12:00:61", "2024-03-10T12:00:00.", "2024-03-10T12:00:00Z", "2024-03-10T12:00:00.12a",
+        "-024-03-10T12:00:00", "2024-3-10T12:00:00", "2024-03-10T1a:00:00", "abcd-ef-ghTij:kl:mn"};
+    const std::string valid = "2024-03-10T12:34:56";
+    for (std::size_t i = 0; i < valid.size(); ++i)
+    {
+        malformed.push_back(valid.substr(0, i));
+        for (char c : {'x', '/', ' ', ':', '\0'})
+        {
+            if (valid[i] >= '0' && valid[i] <= '9')
+            {
+                std::string changed = valid;
+                changed[i] = c;
+                malformed.push_back(changed);
+            }
+        }
+    }
+
+    std::size_t accepted = 0;
+    for (const std::string &timestamp : malformed)
+    {
+        std::time_t actual = 0;
+        if (parse_iso8601(timestamp, actual) && ++accepted <= 5)
+        {
+            std::printf("accepted malformed timestamp \"%s\"\n", timestamp.c_str());
+        }
+    }
+    std::printf("validation malformed %zu samples, %zu accepted\n", malformed.size(), accepted);
+    return accepted == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t samples = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+    std::size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+
+    bool ok = validate("UTC", 0, samples);
+    ok &= validate("EST5", -5 * 3600, samples);
+    ok &= validate("IST-5:30", 5 * 3600 + 30 * 60, samples);
+    ok &= validate_local("America/New_York", samples);
+    ok &= validate_local("Australia/Lord_Howe", samples);
+    ok &= validate_malformed();
+
+    setenv("TZ", "UTC", 1);
+    tzset();
+    std::vector<std::string> plain = random_timestamps(4096, false);
+    std::vector<std::string> fractional = random_timestamps(4096, true);
+
+    run_benchmark("BM_GetTimeMktime", iterations, [&](std::size_t i)
+                  { do_not_optimize(string_to_time_t(plain[i & 4095])); });
+    run_benchmark("BM_ParseIso8601", iterations, [&](std::size_t i)
+                  {
+                      std::time_t t = 0;
+                      do_not_optimize(parse_iso8601(plain[i & 4095], t));
+                      do_not_optimize(t); });
+    run_benchmark("BM_ParseIso8601Fractional", iterations, [&](std::size_t i)
+                  {
+                      std::time_t t = 0;
+                      do_not_optimize(parse_iso8601(fractional[i & 4095], t));
+                      do_not_optimize(t); });
+
+    // Fuso local com horário de verão: deslocamento em cache por hora
+    setenv("TZ", "America/New_York", 1);
+    tzset();
+    TimeZone::reset_local_cache();
+    const TimeZone local = TimeZone::local();
+    // Leituras recentes, como as de sensores ativos: ~40 horas a partir de 2024-03-10
+    std::vector<std::string> recent;
+    for (std::time_t t = 1710000000; recent.size() < 4096; t += 37)
+    {
+        recent.push_back(format_local(t));
+    }
+    run_benchmark("BM_GetTimeMktimeLocal", iterations, [&](std::size_t i)
+                  { do_not_optimize(string_to_time_t(recent[i & 4095])); });
+    run_benchmark("BM_ParseIso8601Local", iterations, [&](std::size_t i)
+                  {
+                      std::time_t t = 0;
+                      do_not_optimize(parse_iso8601(recent[i & 4095], t, local));
+                      do_not_optimize(t); });
+
+    return ok ? 0 : 1;
+}
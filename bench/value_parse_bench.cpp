@@ -0,0 +1,67 @@
+// Compara a conversão da leitura com std::stod + exceções (caminho original)
+// e parse_value, em tráfego válido e em tráfego com muitos valores inválidos.
+//
+// Uso: value_parse_bench [iterations]
+
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "bench_util.hpp"
+#include "protocol.hpp"
+
+static bool parse_with_stod(const std::string &text, double &value)
+{
+    try
+    {
+        value = std::stod(text);
+        return true;
+    }
+    catch (const std::invalid_argument &)
+    {
+        return false;
+    }
+    catch (const std::out_of_range &)
+    {
+        return false;
+    }
+}
+
+// garbage_percent% das entradas são inválidas
+static std::vector<std::string> make_inputs(int garbage_percent)
+{
+    static const char *garbage[] = {"abc", "", "--1", "1e99999", "NaNx", "x78.5"};
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> reading(-100, 100);
+    std::uniform_int_distribution<int> percent(0, 99), pick(0, 5);
+    std::vector<std::string> inputs;
+    for (int i = 0; i < 4096; ++i)
+    {
+        inputs.push_back(percent(rng) < garbage_percent ? garbage[pick(rng)] : std::to_string(reading(rng)));
+    }
+    return inputs;
+}
+
+int main(int argc, char *argv[])
+{
+    std::size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    for (int garbage_percent : {0, 50, 100})
+    {
+        std::vector<std::string> inputs = make_inputs(garbage_percent);
+        std::string suffix = "/garbage:" + std::to_string(garbage_percent);
+
+        run_benchmark("BM_Stod" + suffix, iterations, [&](std::size_t i)
+                      {
+                          double value = 0;
+                          do_not_optimize(parse_with_stod(inputs[i & 4095], value));
+                          do_not_optimize(value); });
+        run_benchmark("BM_ParseValue" + suffix, iterations, [&](std::size_t i)
+                      {
+                          double value = 0;
+                          do_not_optimize(parse_value(inputs[i & 4095], value));
+                          do_not_optimize(value); });
+    }
+    return 0;
+}
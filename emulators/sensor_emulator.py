@@ -9,14 +9,23 @@ def random_string(length):
     letters = string.ascii_lowercase
     return ''.join(random.choice(letters) for i in range(length))
 
-def main(server_ip, server_port, sensor_id, frequency):
+def main(server_ip, server_port, sensor_id, frequency, batch):
     with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
         s.connect((server_ip, server_port))
+        readings = []
         while True:
             value = random.uniform(-100, 100)
             timestamp = datetime.now().isoformat()  # Generate current timestamp
-            message = f"LOG|{sensor_id}|{timestamp}|{value}\r\n"
-            s.sendall(message.encode())
+            if batch <= 1:
+                message = f"LOG|{sensor_id}|{timestamp}|{value}\r\n"
+                s.sendall(message.encode())
+            else:
+                # Send the readings in a single LOGB message once the batch is full
+                readings.append(f"{timestamp}|{value}")
+                if len(readings) == batch:
+                    message = f"LOGB|{sensor_id}|{batch};{';'.join(readings)}\r\n"
+                    s.sendall(message.encode())
+                    readings.clear()
             time.sleep(frequency / 1000.0)  # Convert frequency from ms to s
 
 if __name__ == "__main__":
@@ -29,6 +38,8 @@ if __name__ == "__main__":
                         help='The ID of the sensor.')
     parser.add_argument('--frequency', type=int, default=1000,
                         help='The frequency in milliseconds of sensor readings.')
+    parser.add_argument('--batch', type=int, default=1,
+                        help='Number of readings sent per LOGB message (1 sends one LOG message per reading).')
 
     args = parser.parse_args()
-    main(args.ip, args.port, args.sensor_id, args.frequency)
+    main(args.ip, args.port, args.sensor_id, args.frequency, args.batch)
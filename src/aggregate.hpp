@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <vector>
+#include "log_record.hpp"
+#include "protocol.hpp"
+#include "rollup.hpp"
+
+// Agregação de leituras por intervalos de tempo (AGG): min, max, média,
+// contagem, primeira e última leitura de cada intervalo, calculadas em uma
+// única passada sobre as leituras ou sobre agregados pré-calculados. Os
+// intervalos são alinhados à época UNIX (um intervalo de 60 s começa sempre
+// em um minuto cheio).
+
+enum class AggFunction
+{
+    min,
+    max,
+    avg,
+    count,
+    first,
+    last
+};
+
+struct AggBucket
+{
+    std::int64_t start = 0; // timestamp do início do intervalo
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    double sum = 0;
+    std::uint64_t count = 0;
+    double first = 0; // primeira e última leituras na ordem de gravação
+    double last = 0;
+};
+
+// Lista separada por vírgulas, ex.: "min,max,avg"
+inline bool parse_agg_functions(std::string_view text, std::vector<AggFunction> &functions)
+{
+    functions.clear();
+    for (;;)
+    {
+        std::size_t comma = text.find(',');
+        std::string_view name = text.substr(0, comma);
+        if (name == "min")
+            functions.push_back(AggFunction::min);
+        else if (name == "max")
+            functions.push_back(AggFunction::max);
+        else if (name == "avg")
+            functions.push_back(AggFunction::avg);
+        else if (name == "count")
+            functions.push_back(AggFunction::count);
+        else if (name == "first")
+            functions.push_back(AggFunction::first);
+        else if (name == "last")
+            functions.push_back(AggFunction::last);
+        else
+            return false;
+        if (comma == std::string_view::npos)
+        {
+            return true;
+        }
+        text.remove_prefix(comma + 1);
+    }
+}
+
+// Duração em segundos, com sufixo opcional s, m, h ou d (ex.: "60", "5m", "1h")
+inline bool parse_bucket_seconds(std::string_view text, std::int64_t &seconds)
+{
+    std::int64_t unit = 1;
+    if (!text.empty())
+    {
+        switch (text.back())
+        {
+        case 's':
+            unit = 1;
+            text.remove_suffix(1);
+            break;
+        case 'm':
+            unit = 60;
+            text.remove_suffix(1);
+            break;
+        case 'h':
+            unit = 3600;
+            text.remove_suffix(1);
+            break;
+        case 'd':
+            unit = 86400;
+            text.remove_suffix(1);
+            break;
+        }
+    }
+    int value = 0;
+    if (!parse_count(text, value) || value == 0)
+    {
+        return false;
+    }
+    seconds = static_cast<std::int64_t>(value) * unit;
+    return true;
+}
+
+class Aggregator
+{
+public:
+    explicit Aggregator(std::int64_t bucket_seconds) : bucket_(bucket_seconds) {}
+
+    // Acumula um trecho de leituras. Leituras consecutivas do mesmo
+    // intervalo são reduzidas juntas; fora de ordem continuam corretas, só
+    // mais lentas.
+    void add(const Reading *readings, std::size_t count)
+    {
+        std::size_t i = 0;
+        while (i < count)
+        {
+            const std::int64_t start = floor_to_bucket(readings[i].timestamp, bucket_);
+            const std::int64_t end = start + bucket_;
+            std::size_t j = i + 1;
+            while (j < count && readings[j].timestamp >= start && readings[j].timestamp < end)
+            {
+                ++j;
+            }
+            reduce(readings + i, j - i, bucket_for(start));
+            i = j;
+        }
+    }
+
+    // Acumula um agregado pré-calculado de um intervalo menor contido em
+    // um dos intervalos da consulta
+    void add(const RollupRecord &record)
+    {
+        AggBucket &bucket = bucket_for(floor_to_bucket(record.start, bucket_));
+        if (bucket.count == 0)
+        {
+            bucket.first = record.first;
+        }
+        bucket.min = std::min(bucket.min, record.min);
+        bucket.max = std::max(bucket.max, record.max);
+        bucket.sum += record.sum;
+        bucket.count += record.count;
+        bucket.last = record.last;
+    }
+
+    const std::vector<AggBucket> &buckets() const
+    {
+        return buckets_;
+    }
+
+    std::int64_t bucket_seconds() const
+    {
+        return bucket_;
+    }
+
+private:
+    // Intervalos mantidos em ordem; o caso comum (leituras em ordem) é o
+    // último intervalo ou um novo no fim
+    AggBucket &bucket_for(std::int64_t start)
+    {
+        if (!buckets_.empty() && buckets_.back().start == start)
+        {
+            return buckets_.back();
+        }
+        if (buckets_.empty() || buckets_.back().start < start)
+        {
+            buckets_.emplace_back();
+            buckets_.back().start = start;
+            return buckets_.back();
+        }
+        auto it = std::lower_bound(buckets_.begin(), buckets_.end(), start, [](const AggBucket &bucket, std::int64_t value)
+                                   { return bucket.start < value; });
+        if (it == buckets_.end() || it->start != start)
+        {
+            it = buckets_.insert(it, AggBucket());
+            it->start = start;
+        }
+        return *it;
+    }
+
+    // Redução sem desvios dependentes dos dados, com quatro acumuladores
+    // independentes para que o compilador use instruções vetoriais (minpd,
+    // maxpd, addpd) e a soma não fique presa à latência de uma única adição
+    static void reduce(const Reading *readings, std::size_t count, AggBucket &bucket)
+    {
+        double min[4] = {bucket.min, bucket.min, bucket.min, bucket.min};
+        double max[4] = {bucket.max, bucket.max, bucket.max, bucket.max};
+        double sum[4] = {0, 0, 0, 0};
+        std::size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            for (std::size_t lane = 0; lane < 4; ++lane)
+            {
+                const double v = readings[i + lane].value;
+                min[lane] = v < min[lane] ? v : min[lane];
+                max[lane] = v > max[lane] ? v : max[lane];
+                sum[lane] += v;
+            }
+        }
+        for (; i < count; ++i)
+        {
+            const double v = readings[i].value;
+            min[0] = v < min[0] ? v : min[0];
+            max[0] = v > max[0] ? v : max[0];
+            sum[0] += v;
+        }
+
+        bucket.min = std::min(std::min(min[0], min[1]), std::min(min[2], min[3]));
+        bucket.max = std::max(std::max(max[0], max[1]), std::max(max[2], max[3]));
+        bucket.sum += (sum[0] + sum[1]) + (sum[2] + sum[3]);
+        if (bucket.count == 0)
+        {
+            bucket.first = readings[0].value;
+        }
+        bucket.count += count;
+        bucket.last = readings[count - 1].value;
+    }
+
+    const std::int64_t bucket_;
+    std::vector<AggBucket> buckets_;
+};
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include "log_record.hpp"
+#include "time_codec.hpp"
+
+// Protocolo binário de ingestão, para sensores de alta frequência que não
+// devem pagar pela formatação e leitura de texto. Uma conexão que começa com
+// o byte binary_magic usa este protocolo até o fim; qualquer outro primeiro
+// byte mantém o protocolo texto.
+//
+// Abertura: magic (1 byte), versão (1 byte), tamanho do id (1 byte), id.
+// Quadros:  tamanho do conteúdo (uint32), seguido de leituras de 16 bytes:
+//           timestamp UNIX (int64, UTC) e valor (double IEEE 754).
+//           Timestamps fora de timestamp_in_range invalidam o quadro.
+// Todos os inteiros e valores em little-endian. Um quadro vazio pede a
+// confirmação: o servidor responde com o total de leituras recebidas na
+// conexão (uint64), depois de entregues ao armazenamento.
+
+constexpr unsigned char binary_magic = 0xDA;
+constexpr unsigned char binary_version = 1;
+constexpr std::size_t binary_reading_size = 16;
+constexpr std::size_t binary_frame_header_size = 4;
+constexpr std::uint32_t binary_max_frame_bytes = 1 << 20;
+
+enum class BinaryStatus
+{
+    complete,
+    incomplete, // `length` recebe o total de bytes necessários
+    invalid
+};
+
+inline std::uint64_t load_le64(const char *p)
+{
+    const unsigned char *b = reinterpret_cast<const unsigned char *>(p);
+    std::uint64_t value = 0;
+    for (int i = 7; i >= 0; --i)
+    {
+        value = (value << 8) | b[i];
+    }
+    return value;
+}
+
+inline void store_le64(std::uint64_t value, char *p)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        p[i] = static_cast<char>(value >> (8 * i));
+    }
+}
+
+inline std::uint32_t load_le32(const char *p)
+{
+    const unsigned char *b = reinterpret_cast<const unsigned char *>(p);
+    return static_cast<std::uint32_t>(b[0]) | static_cast<std::uint32_t>(b[1]) << 8 |
+           static_cast<std::uint32_t>(b[2]) << 16 | static_cast<std::uint32_t>(b[3]) << 24;
+}
+
+inline void store_le32(std::uint32_t value, char *p)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        p[i] = static_cast<char>(value >> (8 * i));
+    }
+}
+
+// Abertura da conexão; em `complete`, `length` recebe o tamanho consumido.
+// O id não pode ser vazio nem conter '|', já que não poderia ser consultado
+// pelo protocolo texto.
+inline BinaryStatus parse_binary_hello(std::string_view data, std::string_view &sensor_id, std::size_t &length)
+{
+    if (data.size() < 3)
+    {
+        length = 3;
+        return BinaryStatus::incomplete;
+    }
+    if (static_cast<unsigned char>(data[0]) != binary_magic || static_cast<unsigned char>(data[1]) != binary_version)
+    {
+        return BinaryStatus::invalid;
+    }
+    const std::size_t id_size = static_cast<unsigned char>(data[2]);
+    length = 3 + id_size;
+    if (data.size() < length)
+    {
+        return BinaryStatus::incomplete;
+    }
+    sensor_id = data.substr(3, id_size);
+    if (sensor_id.empty() || sensor_id.find('|') != std::string_view::npos)
+    {
+        return BinaryStatus::invalid;
+    }
+    return BinaryStatus::complete;
+}
+
+// Um quadro; `payload` aponta para as leituras dentro de `data`
+inline BinaryStatus parse_binary_frame(std::string_view data, std::string_view &payload, std::size_t &length)
+{
+    if (data.size() < binary_frame_header_size)
+    {
+        length = binary_frame_header_size;
+        return BinaryStatus::incomplete;
+    }
+    const std::uint32_t payload_size = load_le32(data.data());
+    if (payload_size > binary_max_frame_bytes || payload_size % binary_reading_size != 0)
+    {
+        return BinaryStatus::invalid;
+    }
+    length = binary_frame_header_size + payload_size;
+    if (data.size() < length)
+    {
+        return BinaryStatus::incomplete;
+    }
+    payload = data.substr(binary_frame_header_size, payload_size);
+    return BinaryStatus::complete;
+}
+
+inline Reading decode_binary_reading(const char *p)
+{
+    Reading reading;
+    reading.timestamp = static_cast<std::time_t>(static_cast<std::int64_t>(load_le64(p)));
+    const std::uint64_t bits = load_le64(p + 8);
+    std::memcpy(&reading.value, &bits, sizeof(bits));
+    return reading;
+}
+
+inline void encode_binary_reading(const Reading &reading, char *p)
+{
+    store_le64(static_cast<std::uint64_t>(static_cast<std::int64_t>(reading.timestamp)), p);
+    std::uint64_t bits;
+    std::memcpy(&bits, &reading.value, sizeof(bits));
+    store_le64(bits, p + 8);
+}
+
+// Usadas pelos clientes
+inline std::string encode_binary_hello(std::string_view sensor_id)
+{
+    std::string hello;
+    hello.push_back(static_cast<char>(binary_magic));
+    hello.push_back(static_cast<char>(binary_version));
+    hello.push_back(static_cast<char>(sensor_id.size()));
+    hello.append(sensor_id.data(), sensor_id.size());
+    return hello;
+}
+
+inline void append_binary_frame(const Reading *readings, std::size_t count, std::string &out)
+{
+    const std::size_t offset = out.size();
+    out.resize(offset + binary_frame_header_size + count * binary_reading_size);
+    store_le32(static_cast<std::uint32_t>(count * binary_reading_size), &out[offset]);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        encode_binary_reading(readings[i], &out[offset + binary_frame_header_size + i * binary_reading_size]);
+    }
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "log_record.hpp"
+
+// Compressão de séries temporais no estilo Gorilla (Pelkonen et al., 2015):
+// timestamps por delta-of-delta e valores por XOR com o valor anterior.
+// Leituras a cadência fixa e valores que variam pouco ocupam poucos bits.
+
+// Escrita de bits do mais significativo para o menos significativo. Os bits
+// são acumulados em uma palavra e descarregados em bytes inteiros.
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<std::uint8_t> &out) : out_(out) {}
+
+    // Até 64 bits menos significativos de value
+    void write(std::uint64_t value, int bits)
+    {
+        if (bits > 32)
+        {
+            write(value >> 32, bits - 32);
+            bits = 32;
+        }
+        acc_ = (acc_ << bits) | (value & ((std::uint64_t{1} << bits) - 1));
+        count_ += bits;
+        while (count_ >= 8)
+        {
+            count_ -= 8;
+            out_.push_back(static_cast<std::uint8_t>(acc_ >> count_));
+        }
+    }
+
+    void write_bit(bool bit)
+    {
+        write(bit ? 1 : 0, 1);
+    }
+
+    // Completa o último byte com zeros
+    void flush()
+    {
+        if (count_ > 0)
+        {
+            out_.push_back(static_cast<std::uint8_t>(acc_ << (8 - count_)));
+            count_ = 0;
+        }
+    }
+
+private:
+    std::vector<std::uint8_t> &out_;
+    std::uint64_t acc_ = 0;
+    int count_ = 0; // bits em acc_ ainda não descarregados (< 8)
+};
+
+class BitReader
+{
+public:
+    BitReader(const std::uint8_t *data, std::size_t size) : data_(data), size_(size) {}
+
+    // Lê de 1 a 64 bits. Bits além do fim do buffer são lidos como zero.
+    std::uint64_t read(int bits)
+    {
+        if (bits > 56)
+        {
+            std::uint64_t high = read(bits - 32);
+            return (high << 32) | read(32);
+        }
+        std::uint64_t word = load(position_ >> 3);
+        int offset = static_cast<int>(position_ & 7);
+        position_ += static_cast<std::size_t>(bits);
+        return (word << offset) >> (64 - bits);
+    }
+
+    bool read_bit()
+    {
+        return read(1) != 0;
+    }
+
+private:
+    // 8 bytes em big-endian a partir de `byte`
+    std::uint64_t load(std::size_t byte) const
+    {
+        if (byte + 8 <= size_)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, data_ + byte, sizeof(word));
+            return __builtin_bswap64(word);
+        }
+        std::uint64_t word = 0;
+        for (std::size_t i = 0; i < 8; ++i)
+        {
+            word = (word << 8) | (byte + i < size_ ? data_[byte + i] : 0);
+        }
+        return word;
+    }
+
+    const std::uint8_t *data_;
+    std::size_t size_;
+    std::size_t position_ = 0;
+};
+
+namespace gorilla_detail
+{
+    inline std::uint64_t to_bits(double value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    inline double from_bits(std::uint64_t bits)
+    {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    inline std::uint64_t sign_extend(std::uint64_t value, int bits)
+    {
+        std::uint64_t sign = std::uint64_t{1} << (bits - 1);
+        return (value ^ sign) - sign;
+    }
+}
+
+// Codifica `count` leituras em `out` (acrescentando)
+inline void gorilla_encode(const Reading *readings, std::size_t count, std::vector<std::uint8_t> &out)
+{
+    using namespace gorilla_detail;
+    if (count == 0)
+    {
+        return;
+    }
+
+    BitWriter writer(out);
+    std::int64_t previous_ts = readings[0].timestamp;
+    std::int64_t previous_delta = 0;
+    std::uint64_t previous_bits = to_bits(readings[0].value);
+    int previous_leading = -1;
+    int previous_trailing = 0;
+
+    writer.write(static_cast<std::uint64_t>(previous_ts), 64);
+    writer.write(previous_bits, 64);
+
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        // Timestamp: delta-of-delta em faixas de tamanho crescente
+        std::int64_t ts = readings[i].timestamp;
+        std::int64_t delta = ts - previous_ts;
+        std::int64_t dod = delta - previous_delta;
+        if (dod == 0)
+        {
+            writer.write(0b0, 1);
+        }
+        else if (dod >= -64 && dod <= 63)
+        {
+            writer.write(0b10, 2);
+            writer.write(static_cast<std::uint64_t>(dod), 7);
+        }
+        else if (dod >= -256 && dod <= 255)
+        {
+            writer.write(0b110, 3);
+            writer.write(static_cast<std::uint64_t>(dod), 9);
+        }
+        else if (dod >= -2048 && dod <= 2047)
+        {
+            writer.write(0b1110, 4);
+            writer.write(static_cast<std::uint64_t>(dod), 12);
+        }
+        else
+        {
+            writer.write(0b1111, 4);
+            writer.write(static_cast<std::uint64_t>(dod), 64);
+        }
+        previous_delta = delta;
+        previous_ts = ts;
+
+        // Valor: XOR com o anterior, reaproveitando a janela de bits significativos
+        std::uint64_t bits = to_bits(readings[i].value);
+        std::uint64_t x = bits ^ previous_bits;
+        previous_bits = bits;
+        if (x == 0)
+        {
+            writer.write_bit(false);
+            continue;
+        }
+        writer.write_bit(true);
+
+        int leading = __builtin_clzll(x);
+        int trailing = __builtin_ctzll(x);
+        if (leading > 31)
+        {
+            leading = 31; // 5 bits
+        }
+        if (previous_leading >= 0 && leading >= previous_leading && trailing >= previous_trailing)
+        {
+            writer.write_bit(false);
+            int significant = 64 - previous_leading - previous_trailing;
+            writer.write(x >> previous_trailing, significant);
+        }
+        else
+        {
+            writer.write_bit(true);
+            int significant = 64 - leading - trailing;
+            writer.write(static_cast<std::uint64_t>(leading), 5);
+            writer.write(static_cast<std::uint64_t>(significant - 1), 6); // 1..64
+            writer.write(x >> trailing, significant);
+            previous_leading = leading;
+            previous_trailing = trailing;
+        }
+    }
+    writer.flush();
+}
+
+// Decodifica `count` leituras, acrescentando-as a `out`
+inline void gorilla_decode(const std::uint8_t *data, std::size_t size, std::size_t count, std::vector<Reading> &out)
+{
+    using namespace gorilla_detail;
+    if (count == 0)
+    {
+        return;
+    }
+
+    BitReader reader(data, size);
+    std::int64_t ts = static_cast<std::int64_t>(reader.read(64));
+    std::uint64_t bits = reader.read(64);
+    std::int64_t delta = 0;
+    int leading = 0;
+    int trailing = 0;
+    out.push_back(Reading{static_cast<std::time_t>(ts), from_bits(bits)});
+
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        std::int64_t dod;
+        if (!reader.read_bit())
+            dod = 0;
+        else if (!reader.read_bit())
+            dod = static_cast<std::int64_t>(sign_extend(reader.read(7), 7));
+        else if (!reader.read_bit())
+            dod = static_cast<std::int64_t>(sign_extend(reader.read(9), 9));
+        else if (!reader.read_bit())
+            dod = static_cast<std::int64_t>(sign_extend(reader.read(12), 12));
+        else
+            dod = static_cast<std::int64_t>(reader.read(64));
+        delta += dod;
+        ts += delta;
+
+        if (reader.read_bit())
+        {
+            if (reader.read_bit())
+            {
+                leading = static_cast<int>(reader.read(5));
+                int significant = static_cast<int>(reader.read(6)) + 1;
+                trailing = 64 - leading - significant;
+            }
+            int significant = 64 - leading - trailing;
+            bits ^= reader.read(significant) << trailing;
+        }
+        out.push_back(Reading{static_cast<std::time_t>(ts), from_bits(bits)});
+    }
+}
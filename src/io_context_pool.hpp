@@ -0,0 +1,81 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Conjunto de io_contexts, cada um executado por uma única thread.
+// Cada sessão fica presa ao io_context do seu socket, portanto os handlers
+// de uma mesma sessão nunca executam concorrentemente (dispensa strands).
+class IoContextPool
+{
+public:
+    explicit IoContextPool(std::size_t pool_size)
+    {
+        if (pool_size == 0)
+        {
+            throw std::invalid_argument("IoContextPool size must be greater than zero");
+        }
+
+        for (std::size_t i = 0; i < pool_size; ++i)
+        {
+            auto io_context = std::make_shared<boost::asio::io_context>(1);
+            work_guards_.emplace_back(boost::asio::make_work_guard(*io_context));
+            io_contexts_.push_back(io_context);
+        }
+    }
+
+    // Executa todos os io_contexts e bloqueia até que todos terminem.
+    void run()
+    {
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < io_contexts_.size(); ++i)
+        {
+            threads.emplace_back([io_context = io_contexts_[i]]
+                                 { io_context->run(); });
+        }
+
+        // A thread chamadora executa o primeiro io_context
+        io_contexts_[0]->run();
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    void stop()
+    {
+        for (auto &io_context : io_contexts_)
+        {
+            io_context->stop();
+        }
+    }
+
+    // Distribui as conexões entre os io_contexts em round-robin
+    boost::asio::io_context &get_io_context()
+    {
+        boost::asio::io_context &io_context = *io_contexts_[next_io_context_];
+        next_io_context_ = (next_io_context_ + 1) % io_contexts_.size();
+        return io_context;
+    }
+
+    boost::asio::io_context &at(std::size_t index)
+    {
+        return *io_contexts_.at(index);
+    }
+
+    std::size_t size() const
+    {
+        return io_contexts_.size();
+    }
+
+private:
+    using work_guard_type = boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+
+    std::vector<std::shared_ptr<boost::asio::io_context>> io_contexts_;
+    std::vector<work_guard_type> work_guards_;
+    std::size_t next_io_context_ = 0;
+};
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Anel de io_uring mínimo, usado sem a liburing (apenas as chamadas de
+// sistema e linux/io_uring.h): várias escritas são preparadas e submetidas
+// ao kernel com um único io_uring_enter, que também espera a conclusão de
+// todas. Disponível com -DDAS_IO_URING=ON (Linux 5.6 ou mais recente).
+class IoUring
+{
+public:
+    explicit IoUring(unsigned entries = 256)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0)
+        {
+            error_ = errno;
+            return;
+        }
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap)
+        {
+            sq_ring_size_ = cq_ring_size_ = sq_ring_size_ > cq_ring_size_ ? sq_ring_size_ : cq_ring_size_;
+        }
+        sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        cq_ring_ = single_mmap ? sq_ring_
+                               : ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                                        IORING_OFF_CQ_RING);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+        if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes == MAP_FAILED)
+        {
+            error_ = errno;
+            if (sqes != MAP_FAILED)
+            {
+                ::munmap(sqes, sqes_size_);
+            }
+            release(); // sqes_ ainda é nulo
+            return;
+        }
+
+        char *sq = static_cast<char *>(sq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        sqes_ = static_cast<io_uring_sqe *>(sqes);
+        char *cq = static_cast<char *>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        capacity_ = params.sq_entries;
+    }
+
+    ~IoUring()
+    {
+        release();
+    }
+
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    // false se o kernel não oferece io_uring (ou ele está bloqueado, como
+    // em alguns contêineres) ou depois de uma falha em submit_and_wait;
+    // error() indica o motivo
+    bool is_open() const
+    {
+        return capacity_ > 0;
+    }
+
+    int error() const
+    {
+        return error_;
+    }
+
+    // Máximo de escritas preparadas por submissão
+    unsigned capacity() const
+    {
+        return capacity_;
+    }
+
+    // Prepara a escrita de `size` bytes em `offset`; `user_data` identifica
+    // a escrita na conclusão. No máximo capacity() escritas por submissão.
+    void prepare_write(int fd, const void *data, std::size_t size, std::uint64_t offset, std::uint64_t user_data)
+    {
+        const unsigned index = sq_tail_local_ & sq_mask_;
+        io_uring_sqe &sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_WRITE;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(data);
+        sqe.len = static_cast<std::uint32_t>(size);
+        sqe.off = offset;
+        sqe.user_data = user_data;
+        sq_array_[index] = index;
+        ++sq_tail_local_;
+        ++prepared_;
+    }
+
+    // Submete as escritas preparadas e espera todas; chama
+    // complete(user_data, result) para cada uma, com o número de bytes
+    // escritos ou -errno. Se o io_uring_enter falhar, as escritas já
+    // submetidas continuam sendo aguardadas (o kernel pode estar usando os
+    // buffers delas), o anel é fechado e a função retorna false: as
+    // escritas sem conclusão nunca chegaram ao kernel.
+    template <typename Completion>
+    bool submit_and_wait(Completion &&complete)
+    {
+        __atomic_store_n(sq_tail_, sq_tail_local_, __ATOMIC_RELEASE);
+        unsigned to_submit = prepared_;
+        unsigned pending = prepared_;
+        prepared_ = 0;
+        bool failed = false;
+        while (pending > 0)
+        {
+            long submitted = ::syscall(__NR_io_uring_enter, fd_, to_submit, pending, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (submitted < 0)
+            {
+                // Com EAGAIN/EBUSY o kernel pede que as conclusões sejam
+                // consumidas antes de aceitar novas escritas. Uma espera sem
+                // submissões só falha assim (ou com EINTR) e é repetida.
+                if (errno != EINTR && errno != EAGAIN && errno != EBUSY && to_submit > 0)
+                {
+                    error_ = errno;
+                    failed = true;
+                    pending -= to_submit;
+                    to_submit = 0;
+                }
+                submitted = 0;
+            }
+            to_submit -= static_cast<unsigned>(submitted);
+
+            unsigned head = *cq_head_;
+            const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head)
+            {
+                const io_uring_cqe &cqe = cqes_[head & cq_mask_];
+                complete(cqe.user_data, cqe.res);
+                --pending;
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        }
+        if (failed)
+        {
+            // As escritas abandonadas continuam na fila de submissão
+            release();
+        }
+        return !failed;
+    }
+
+private:
+    void release()
+    {
+        if (sqes_)
+        {
+            ::munmap(sqes_, sqes_size_);
+            sqes_ = nullptr;
+        }
+        if (cq_ring_ && cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_)
+        {
+            ::munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_ && sq_ring_ != MAP_FAILED)
+        {
+            ::munmap(sq_ring_, sq_ring_size_);
+        }
+        sq_ring_ = cq_ring_ = nullptr;
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        capacity_ = 0;
+    }
+
+    int fd_ = -1;
+    int error_ = 0;
+    unsigned capacity_ = 0;
+    void *sq_ring_ = nullptr;
+    void *cq_ring_ = nullptr;
+    std::size_t sq_ring_size_ = 0;
+    std::size_t cq_ring_size_ = 0;
+    std::size_t sqes_size_ = 0;
+    unsigned *sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned *sq_array_ = nullptr;
+    io_uring_sqe *sqes_ = nullptr;
+    unsigned *cq_head_ = nullptr;
+    unsigned *cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe *cqes_ = nullptr;
+    unsigned sq_tail_local_ = 0;
+    unsigned prepared_ = 0;
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "log_record.hpp"
+
+// Formatos dos arquivos de log de sensor.
+//
+// v1: sequência de LogRecord de 48 bytes, sem cabeçalho (formato original).
+// v2: cabeçalho de 64 bytes seguido de registros de 16 bytes (timestamp,
+//     valor); o id do sensor aparece uma única vez, no cabeçalho.
+enum class LogFormat
+{
+    v1 = 1,
+    v2 = 2
+};
+
+constexpr char log_file_magic[4] = {'D', 'A', 'S', 'L'};
+
+#pragma pack(push, 1)
+struct LogFileHeader
+{
+    char magic[4];             // "DASL"
+    std::uint16_t version;     // 2
+    std::uint16_t record_size; // sizeof(CompactRecord)
+    std::uint32_t header_size; // sizeof(LogFileHeader); os registros começam aqui
+    char sensor_id[32];        // id do sensor, terminado em '\0'
+    char reserved[20];
+};
+
+struct CompactRecord
+{
+    std::int64_t timestamp; // timestamp UNIX
+    double value;           // valor da leitura
+};
+#pragma pack(pop)
+
+static_assert(sizeof(LogFileHeader) == 64, "LogFileHeader must be 64 bytes");
+static_assert(sizeof(CompactRecord) == 16, "CompactRecord must be 16 bytes");
+
+// Layout de um arquivo de log: onde começam os registros e o tamanho de cada um
+struct LogLayout
+{
+    LogFormat format = LogFormat::v2;
+    std::size_t data_offset = sizeof(LogFileHeader);
+    std::size_t record_size = sizeof(CompactRecord);
+
+    static LogLayout for_format(LogFormat format)
+    {
+        LogLayout layout;
+        layout.format = format;
+        layout.data_offset = format == LogFormat::v2 ? sizeof(LogFileHeader) : 0;
+        layout.record_size = format == LogFormat::v2 ? sizeof(CompactRecord) : sizeof(LogRecord);
+        return layout;
+    }
+
+    std::size_t record_count(std::size_t file_size) const
+    {
+        return file_size > data_offset ? (file_size - data_offset) / record_size : 0;
+    }
+
+    // Lê o i-ésimo registro a partir do início do arquivo
+    Reading decode(const char *file_data, std::size_t index) const
+    {
+        const char *p = file_data + data_offset + index * record_size;
+        if (format == LogFormat::v2)
+        {
+            CompactRecord record;
+            std::memcpy(&record, p, sizeof(record));
+            return Reading{static_cast<std::time_t>(record.timestamp), record.value};
+        }
+        LogRecord record;
+        std::memcpy(&record, p, sizeof(record));
+        return Reading{record.timestamp, record.value};
+    }
+
+    // Acrescenta a codificação de `reading` em `out` (record_size bytes)
+    template <typename Buffer>
+    void encode(std::string_view sensor_id, const Reading &reading, Buffer &out) const
+    {
+        if (format == LogFormat::v2)
+        {
+            CompactRecord record{static_cast<std::int64_t>(reading.timestamp), reading.value};
+            const char *bytes = reinterpret_cast<const char *>(&record);
+            out.insert(out.end(), bytes, bytes + sizeof(record));
+            return;
+        }
+        LogRecord record{};
+        std::memcpy(record.sensor_id, sensor_id.data(), std::min(sensor_id.size(), sizeof(record.sensor_id) - 1));
+        record.timestamp = reading.timestamp;
+        record.value = reading.value;
+        const char *bytes = reinterpret_cast<const char *>(&record);
+        out.insert(out.end(), bytes, bytes + sizeof(record));
+    }
+};
+
+inline LogFileHeader make_log_header(std::string_view sensor_id)
+{
+    LogFileHeader header{};
+    std::memcpy(header.magic, log_file_magic, sizeof(header.magic));
+    header.version = static_cast<std::uint16_t>(LogFormat::v2);
+    header.record_size = sizeof(CompactRecord);
+    header.header_size = sizeof(LogFileHeader);
+    std::memcpy(header.sensor_id, sensor_id.data(), std::min(sensor_id.size(), sizeof(header.sensor_id) - 1));
+    return header;
+}
+
+// Identifica o formato pelos primeiros bytes do arquivo (`data`, `size`) e
+// pelo seu tamanho total. Um arquivo só é v2 se tem o magic, um cabeçalho
+// consistente e registros alinhados ao cabeçalho (ou, com um registro
+// incompleto no fim, se também não estiver alinhado como v1). Qualquer
+// outro arquivo é v1, inclusive o de um sensor cujo id começa com "DASL".
+inline bool detect_log_layout(const char *data, std::size_t size, std::size_t file_size, LogLayout &layout)
+{
+    layout = LogLayout::for_format(LogFormat::v1);
+    LogFileHeader header;
+    if (size < sizeof(header) || std::memcmp(data, log_file_magic, sizeof(log_file_magic)) != 0)
+    {
+        return true;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.version != static_cast<std::uint16_t>(LogFormat::v2) ||
+        header.record_size != sizeof(CompactRecord) || header.header_size < sizeof(LogFileHeader) ||
+        header.header_size > file_size)
+    {
+        return true;
+    }
+    const bool v2_aligned = (file_size - header.header_size) % sizeof(CompactRecord) == 0;
+    const bool v1_aligned = file_size % sizeof(LogRecord) == 0;
+    if (!v2_aligned && v1_aligned)
+    {
+        return true;
+    }
+    layout = LogLayout::for_format(LogFormat::v2);
+    layout.data_offset = header.header_size;
+    return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <ctime>
+
+#pragma pack(push, 1)
+struct LogRecord
+{
+    char sensor_id[32];    // supondo um ID de sensor de até 32 caracteres
+    std::time_t timestamp; // timestamp UNIX
+    double value;          // valor da leitura
+};
+#pragma pack(pop)
+
+// Leitura sem o id do sensor, como devolvida pelas consultas
+struct Reading
+{
+    std::time_t timestamp;
+    double value;
+};
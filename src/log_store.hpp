@@ -0,0 +1,1559 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include "log_format.hpp"
+#include "log_record.hpp"
+#include "mapped_file.hpp"
+#include "ring_buffer.hpp"
+#include "aggregate.hpp"
+#include "rollup.hpp"
+#include "segment_file.hpp"
+#include "sensor_catalog.hpp"
+#include "time_index.hpp"
+#include "write_ahead_log.hpp"
+#ifdef DAS_IO_URING
+#include "io_uring.hpp"
+#endif
+
+// Onde as leituras recebidas são gravadas primeiro
+enum class StorageEngine
+{
+    files, // lotes acrescentados diretamente aos arquivos de cada sensor
+    wal    // WAL compartilhado, compactado periodicamente nos arquivos dos sensores
+};
+
+// Garantia de durabilidade de cada lote gravado
+enum class Durability
+{
+    none,     // lote entregue ao kernel apenas quando enche (ou ao ler/encerrar)
+    flush,    // lote entregue ao kernel ao encher ou ao expirar a janela
+    fdatasync // como flush, seguido de fdatasync a cada lote
+};
+
+struct StoreOptions
+{
+    std::size_t batch_bytes = 4096;            // tamanho que dispara a escrita do lote
+    std::chrono::milliseconds flush_window{5}; // idade máxima de um lote pendente
+    Durability durability = Durability::flush;
+    std::size_t cache_records = 1000; // leituras recentes mantidas em memória por sensor
+    LogFormat format = LogFormat::v2;  // formato de arquivos novos
+    std::size_t segment_records = 0;   // selar o log em blocos comprimidos a cada N leituras (0 = desativado)
+    std::size_t index_interval = 1024; // registros por entrada do índice de timestamps
+    bool rollups = false;              // manter agregados de 1 min, 1 h e 1 dia durante a gravação
+    std::size_t max_open_sensors = 256; // sensores com arquivos abertos ao mesmo tempo (0 = sem limite)
+    std::string catalog_path = "sensors.cat"; // catálogo de sensores (vazio = sem catálogo)
+    StorageEngine storage = StorageEngine::files;
+    std::size_t wal_bytes = std::size_t(64) << 20; // tamanho do WAL que dispara a compactação
+};
+
+class SensorLog;
+
+// Limita o número de sensores com arquivos abertos (descritores e
+// mapeamentos) e, com eles, a memória por sensor. Os sensores abertos formam
+// um anel percorrido por um ponteiro (algoritmo do relógio, uma aproximação
+// de LRU): cada uso de um sensor apenas marca um bit, sem locks globais; ao
+// abrir um sensor além do limite o ponteiro avança limpando as marcas e
+// fecha o primeiro sensor não usado desde a passada anterior. Um sensor
+// fechado reabre seus arquivos no próximo uso.
+class OpenFileCache
+{
+public:
+    explicit OpenFileCache(std::size_t capacity) : capacity_(capacity) {}
+
+    OpenFileCache(const OpenFileCache &) = delete;
+    OpenFileCache &operator=(const OpenFileCache &) = delete;
+
+    // Chamada por um sensor que acabou de abrir seus arquivos, com o mutex
+    // do sensor adquirido
+    void opened(SensorLog &log, bool reopen);
+
+    std::size_t open_count() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return ring_.size();
+    }
+
+    std::uint64_t evictions() const
+    {
+        return evictions_.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t reopens() const
+    {
+        return reopens_.load(std::memory_order_relaxed);
+    }
+
+private:
+    const std::size_t capacity_;
+    mutable std::mutex mutex_;
+    std::vector<SensorLog *> ring_;
+    std::size_t hand_ = 0;
+    std::atomic<std::uint64_t> evictions_{0};
+    std::atomic<std::uint64_t> reopens_{0};
+};
+
+// Ligações de um SensorLog com o LogStore que o registrou
+// Sensores com lote pendente, percorridos pela thread de flush do LogStore.
+// Um sensor entra na lista sob o próprio mutex, antes de copiar leituras
+// para o WAL: a compactação que rotaciona o WAL e depois troca a lista
+// encontra todo sensor com leituras no WAL anterior.
+struct DirtyList
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<SensorLog *> logs;
+
+    void add(SensorLog *log)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        logs.push_back(log);
+    }
+};
+
+struct SensorLogContext
+{
+    std::uint32_t handle = 0;            // número denso do sensor nesta execução
+    OpenFileCache *open_files = nullptr; // nullptr: arquivos sempre abertos
+    SensorCatalog *catalog = nullptr;    // nullptr: sensor não catalogado
+    std::uint32_t catalog_handle = SensorCatalog::no_handle;
+    SensorSummary summary; // estatísticas lidas do catálogo
+    WriteAheadLog *wal = nullptr; // nullptr: lotes gravados direto nos arquivos
+    DirtyList *dirty = nullptr;   // nullptr: lotes gravados apenas quando cheios
+};
+
+// Arquivo de log de um único sensor, com seu próprio mutex: escritas em
+// sensores diferentes não competem entre si. Os registros são acumulados em
+// um lote (group commit) e gravados com um único write(2).
+//
+// Com segment_records > 0, quando o arquivo de log atinge esse número de
+// registros eles são selados em um bloco comprimido no arquivo de segmentos
+// (SENSOR_ID.gts) e o log volta a conter apenas o cabeçalho.
+//
+// Com um WAL (e um handle no catálogo, que o identifica nos registros), as
+// leituras são copiadas para o WAL e o lote fica em memória até a próxima
+// compactação, que o grava de uma só vez; consultas que leem os arquivos
+// gravam o lote antes, como no modo direto.
+class SensorLog
+{
+public:
+    SensorLog(std::string sensor_id, const StoreOptions &options, const SensorLogContext &context = SensorLogContext())
+        : sensor_id_(std::move(sensor_id)), options_(options), handle_(context.handle),
+          open_files_(context.open_files), catalog_(context.catalog), catalog_handle_(context.catalog_handle),
+          summary_(context.summary), wal_(context.catalog_handle != SensorCatalog::no_handle ? context.wal : nullptr),
+          dirty_(options.durability != Durability::none || wal_ ? context.dirty : nullptr),
+          cache_(options.cache_records) {}
+
+    ~SensorLog()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        write_pending();
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+        }
+    }
+
+    SensorLog(const SensorLog &) = delete;
+    SensorLog &operator=(const SensorLog &) = delete;
+
+    void append(const Reading &reading)
+    {
+        append(&reading, 1);
+    }
+
+    // Várias leituras sob um único lock
+    void append(const Reading *readings, std::size_t count)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        append_locked(readings, count, wal_ != nullptr);
+    }
+
+    // Reaplica um registro do WAL, se a leitura ainda não foi gravada nos
+    // arquivos do sensor. Um registro adiante da próxima leitura esperada
+    // (faltam registros anteriores no WAL) não é reaplicado: retorna false.
+    bool replay(const WalRecord &record)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!open_file())
+        {
+            return true;
+        }
+        const std::uint64_t next = stored_records() + pending_.size() / layout_.record_size;
+        if (record.sequence > next)
+        {
+            return false;
+        }
+        if (record.sequence == next)
+        {
+            Reading reading{static_cast<std::time_t>(record.timestamp), record.value};
+            append_locked(&reading, 1, false);
+        }
+        return true;
+    }
+
+    // Se o lote aguarda a compactação do WAL, em vez da janela de flush
+    bool uses_wal() const
+    {
+        return wal_ != nullptr;
+    }
+
+    // Grava o lote pendente, qualquer que seja sua idade
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        write_pending();
+    }
+
+    // Grava o lote se ele é anterior a cutoff. Retorna true se o sensor ainda
+    // tem dados pendentes (lote recente ou gravação que falhou com WAL) e
+    // deve continuar na lista do LogStore.
+    bool flush_if_older(std::chrono::steady_clock::time_point cutoff)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!pending_.empty() && pending_since_ > cutoff)
+        {
+            return true;
+        }
+        write_pending();
+        queued_ = !pending_.empty();
+        return queued_;
+    }
+
+    // Copia as últimas `count` leituras (ou todas, se houver menos) para
+    // `readings`. Consultas que cabem no cache em memória não tocam o disco;
+    // as demais leem do arquivo mapeado. `from_cache` indica qual caminho foi
+    // usado. Retorna false se o arquivo não pôde ser aberto ou mapeado.
+    bool read_last(std::size_t count, std::vector<Reading> &readings, bool &from_cache)
+    {
+        readings.clear();
+        std::lock_guard<std::mutex> lock(mutex_);
+        warm_cache();
+        if (!open_file())
+        {
+            return false;
+        }
+
+        const std::size_t total_records = stored_records() + pending_.size() / layout_.record_size;
+        count = std::min(count, total_records);
+        from_cache = count <= cache_.size();
+        if (from_cache)
+        {
+            cache_.copy_last(count, readings);
+            return true;
+        }
+
+        write_pending();
+        return read_stored(count, readings);
+    }
+
+    // Copia para `readings` as leituras com timestamp em [from, to]
+    bool read_range(std::time_t from, std::time_t to, std::vector<Reading> &readings)
+    {
+        readings.clear();
+        return scan_range(from, to, [&readings](const Reading *chunk, std::size_t count)
+                          { readings.insert(readings.end(), chunk, chunk + count); });
+    }
+
+    // Chama visit(readings, count) em ordem para trechos das leituras com
+    // timestamp em [from, to], sem materializar o intervalo inteiro. Os
+    // blocos selados são localizados pelos timestamps dos seus cabeçalhos e
+    // o log pelo índice esparso, sem varrer o arquivo desde o início.
+    template <typename Visitor>
+    bool scan_range(std::time_t from, std::time_t to, Visitor &&visit)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!open_file())
+        {
+            return false;
+        }
+        write_pending();
+        return scan_stored(from, to, visit);
+    }
+
+    // Agrega as leituras em [from, to]. Com os agregados pré-calculados
+    // ativos e um intervalo de consulta múltiplo de um dos níveis, a parte
+    // alinhada ao nível é lida dos agregados e apenas as bordas das
+    // leituras. `used_rollups` indica se os agregados foram usados.
+    bool aggregate(std::time_t from, std::time_t to, Aggregator &aggregator, bool &used_rollups)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        used_rollups = false;
+        if (!open_file())
+        {
+            return false;
+        }
+        write_pending();
+
+        auto add_readings = [&aggregator](const Reading *readings, std::size_t count)
+        { aggregator.add(readings, count); };
+
+        RollupFile *tier = nullptr;
+        if (rollups_open_)
+        {
+            for (RollupFile &rollup : rollups_)
+            {
+                if (aggregator.bucket_seconds() % rollup.bucket_seconds() == 0)
+                {
+                    tier = &rollup;
+                }
+            }
+        }
+        if (!tier || to < from)
+        {
+            return scan_stored(from, to, add_readings);
+        }
+
+        // [from, first) e [last, to] vêm das leituras; [first, last) dos agregados
+        const std::int64_t seconds = tier->bucket_seconds();
+        const std::int64_t first = floor_to_bucket(static_cast<std::int64_t>(from) + seconds - 1, seconds);
+        const std::int64_t last = floor_to_bucket(static_cast<std::int64_t>(to) + 1, seconds);
+        if (first >= last)
+        {
+            return scan_stored(from, to, add_readings);
+        }
+        used_rollups = true;
+        return (first == from || scan_stored(from, static_cast<std::time_t>(first - 1), add_readings)) &&
+               tier->scan(first, last - 1, [&aggregator](const RollupRecord &record)
+                          { aggregator.add(record); }) &&
+               (last > to || scan_stored(static_cast<std::time_t>(last), to, add_readings));
+    }
+
+    std::string path() const
+    {
+        return sensor_id_ + ".log";
+    }
+
+    std::string segment_path() const
+    {
+        return sensor_id_ + ".gts";
+    }
+
+    std::string index_path() const
+    {
+        return sensor_id_ + ".idx";
+    }
+
+    std::string rollup_path(std::int64_t bucket_seconds) const
+    {
+        return sensor_id_ + ".r" + std::to_string(bucket_seconds);
+    }
+
+    const std::string &sensor_id() const
+    {
+        return sensor_id_;
+    }
+
+    // Número do sensor no LogStore (LogStore::at)
+    std::uint32_t handle() const
+    {
+        return handle_;
+    }
+
+    // Primeiro e último timestamp e número de leituras, inclusive pendentes
+    SensorSummary summary()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SensorSummary summary = summary_;
+        summary.records = (fd_ >= 0 ? stored_records() : summary_.records) + pending_.size() / layout_.record_size;
+        return summary;
+    }
+
+    // Grava o lote pendente e fecha os arquivos do sensor, liberando também
+    // o cache de leituras recentes; tudo é reaberto sob demanda. Retorna
+    // false, sem esperar, se o sensor está em uso.
+    bool try_close_files()
+    {
+        std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+        if (!lock.owns_lock() || fd_ < 0)
+        {
+            return false;
+        }
+        write_pending();
+        index_.close();
+        segments_.close();
+        for (RollupFile &rollup : rollups_)
+        {
+            rollup.close();
+        }
+        rollups_open_ = false;
+        mapping_.unmap();
+        ::close(fd_);
+        fd_ = -1;
+        file_size_ = 0;
+        cache_.clear();
+        cache_warm_ = false;
+        std::vector<char>().swap(pending_);
+        return true;
+    }
+
+#ifdef DAS_IO_URING
+    // Como flush_if_older para cada sensor de `logs`, mas os lotes vencidos
+    // de até ring.capacity() sensores são gravados com uma única submissão
+    // ao io_uring, em vez de um write(2) por sensor. Os sensores que ainda
+    // têm dados pendentes vão para `still_pending`. Se a submissão falhar o
+    // anel é fechado e os sensores restantes são gravados com write(2).
+    static void flush_batch(IoUring &ring, const std::vector<SensorLog *> &logs,
+                            std::chrono::steady_clock::time_point cutoff, std::vector<SensorLog *> &still_pending)
+    {
+        std::vector<std::unique_lock<std::mutex>> locks;
+        std::vector<SensorLog *> batch;
+        std::vector<SensorLog *> closed;
+        std::size_t next = 0;
+        while (next < logs.size() && ring.is_open())
+        {
+            // Os mutexes ficam adquiridos até a conclusão das escritas. Abrir
+            // arquivos aqui poderia fechar outro sensor do lote, então
+            // sensores fechados são gravados depois, um a um.
+            for (; next < logs.size() && batch.size() < ring.capacity(); ++next)
+            {
+                SensorLog *log = logs[next];
+                std::unique_lock<std::mutex> lock(log->mutex_);
+                if (!log->pending_.empty() && log->pending_since_ > cutoff)
+                {
+                    still_pending.push_back(log);
+                    continue;
+                }
+                if (log->fd_ < 0)
+                {
+                    closed.push_back(log);
+                    continue;
+                }
+                log->queued_ = false;
+                if (log->pending_.empty())
+                {
+                    continue;
+                }
+                ring.prepare_write(log->fd_, log->pending_.data(), log->pending_.size(), log->file_size_, batch.size());
+                batch.push_back(log);
+                locks.push_back(std::move(lock));
+            }
+
+            // Escritas sem conclusão não foram submetidas e são feitas por
+            // complete_write com write(2)
+            std::vector<bool> done(batch.size(), false);
+            if (!ring.submit_and_wait([&](std::uint64_t index, int result)
+                                      {
+                                          batch[index]->complete_write(result);
+                                          done[index] = true; }))
+            {
+                std::cerr << "Error: io_uring submission failed (" << std::strerror(ring.error())
+                          << "); writing batches with write(2)" << std::endl;
+            }
+            for (std::size_t i = 0; i < batch.size(); ++i)
+            {
+                if (!done[i])
+                {
+                    batch[i]->complete_write(0);
+                }
+                if (!batch[i]->pending_.empty())
+                {
+                    batch[i]->queued_ = true;
+                    still_pending.push_back(batch[i]);
+                }
+            }
+            batch.clear();
+            locks.clear();
+        }
+
+        for (; next < logs.size(); ++next)
+        {
+            if (logs[next]->flush_if_older(cutoff))
+            {
+                still_pending.push_back(logs[next]);
+            }
+        }
+
+        for (SensorLog *log : closed)
+        {
+            if (log->flush_if_older(cutoff))
+            {
+                still_pending.push_back(log);
+            }
+        }
+    }
+#endif
+
+    // Marca de uso recente lida pelo OpenFileCache
+    std::atomic<bool> referenced{false};
+
+private:
+    // Deve ser chamada com mutex_ adquirido. Com `to_wal`, as leituras
+    // também são copiadas para o WAL, numeradas a partir das já recebidas.
+    void append_locked(const Reading *readings, std::size_t count, bool to_wal)
+    {
+        warm_cache();
+        if (!open_file())
+        {
+            return;
+        }
+        if (count > 0 && dirty_ && !queued_)
+        {
+            queued_ = true;
+            dirty_->add(this);
+        }
+        constexpr std::size_t wal_chunk = 64;
+        WalRecord records[wal_chunk];
+        std::size_t filled = 0;
+        std::uint64_t sequence = stored_records() + pending_.size() / layout_.record_size;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const Reading &reading = readings[i];
+            const std::int64_t timestamp = static_cast<std::int64_t>(reading.timestamp);
+            summary_.first_timestamp = std::min(summary_.first_timestamp, timestamp);
+            summary_.last_timestamp = std::max(summary_.last_timestamp, timestamp);
+            cache_.push(reading);
+            if (pending_.empty())
+            {
+                pending_since_ = std::chrono::steady_clock::now();
+            }
+            index_.add(layout_.record_count(file_size_) + pending_.size() / layout_.record_size, reading.timestamp);
+            if (rollups_open_)
+            {
+                for (RollupFile &rollup : rollups_)
+                {
+                    rollup.add(reading);
+                }
+            }
+            layout_.encode(sensor_id_, reading, pending_);
+
+            if (to_wal)
+            {
+                WalRecord &record = records[filled++];
+                record.sensor = catalog_handle_;
+                record.reserved = 0;
+                record.sequence = sequence++;
+                record.timestamp = timestamp;
+                record.value = reading.value;
+                if (filled == wal_chunk)
+                {
+                    wal_->append(records, filled);
+                    filled = 0;
+                }
+            }
+            else if (pending_.size() >= options_.batch_bytes && !wal_)
+            {
+                write_pending();
+            }
+        }
+        if (filled > 0)
+        {
+            wal_->append(records, filled);
+        }
+    }
+
+    // Deve ser chamada com mutex_ adquirido. Como scan_range, sem gravar o
+    // lote pendente.
+    template <typename Visitor>
+    bool scan_stored(std::time_t from, std::time_t to, Visitor &&visit)
+    {
+        if (!segments_.scan_range(from, to, visit))
+        {
+            return false;
+        }
+        const std::size_t raw_records = layout_.record_count(file_size_);
+        if (raw_records == 0)
+        {
+            return true;
+        }
+        if (!map_file())
+        {
+            return false;
+        }
+
+        // Com leituras fora de ordem o log é lido até o fim
+        const bool ordered = index_.ordered();
+        constexpr std::size_t chunk_size = 1024;
+        Reading chunk[chunk_size];
+        std::size_t filled = 0;
+        for (std::size_t i = index_.seek(from); i < raw_records; ++i)
+        {
+            Reading reading = layout_.decode(mapping_.data(), i);
+            if (reading.timestamp > to && ordered)
+            {
+                break;
+            }
+            if (reading.timestamp >= from && reading.timestamp <= to)
+            {
+                chunk[filled++] = reading;
+                if (filled == chunk_size)
+                {
+                    visit(chunk, filled);
+                    filled = 0;
+                }
+            }
+        }
+        if (filled > 0)
+        {
+            visit(chunk, filled);
+        }
+        return true;
+    }
+
+    // Deve ser chamada com mutex_ adquirido, antes de qualquer acesso aos
+    // arquivos do sensor: abre-os se necessário e marca o sensor como usado.
+    bool open_file()
+    {
+        referenced.store(true, std::memory_order_relaxed);
+        if (fd_ >= 0)
+        {
+            return true;
+        }
+        if (!open_log())
+        {
+            return false;
+        }
+        refresh_summary();
+        if (open_files_)
+        {
+            open_files_->opened(*this, opened_before_);
+        }
+        opened_before_ = true;
+        return true;
+    }
+
+    // Deve ser chamada com mutex_ adquirido. Corrige as estatísticas do
+    // catálogo se não correspondem aos arquivos (sensor importado ou
+    // servidor interrompido antes de atualizá-las).
+    void refresh_summary()
+    {
+        const std::size_t raw_records = layout_.record_count(file_size_);
+        if (summary_.records == stored_records() || (raw_records > 0 && !map_file()))
+        {
+            return;
+        }
+        summary_ = SensorSummary();
+        summary_.records = stored_records();
+        for (const SegmentFile::Block &block : segments_.blocks())
+        {
+            summary_.first_timestamp = std::min(summary_.first_timestamp, block.header.min_timestamp);
+            summary_.last_timestamp = std::max(summary_.last_timestamp, block.header.max_timestamp);
+        }
+        if (raw_records > 0)
+        {
+            const std::pair<std::int64_t, std::int64_t> range = raw_time_range(raw_records);
+            summary_.first_timestamp = std::min(summary_.first_timestamp, range.first);
+            summary_.last_timestamp = std::max(summary_.last_timestamp, range.second);
+        }
+        if (catalog_)
+        {
+            catalog_->update(catalog_handle_, summary_);
+        }
+    }
+
+    // Deve ser chamada com mutex_ adquirido. O mesmo descritor serve para
+    // as escritas (O_APPEND) e para o mapeamento de leitura. Arquivos novos
+    // são criados no formato configurado; arquivos existentes mantêm o seu.
+    bool open_log()
+    {
+        fd_ = ::open(path().c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+        {
+            std::cerr << "Error: Could not open log file for sensor " << sensor_id_
+                      << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        struct stat st;
+        file_size_ = ::fstat(fd_, &st) == 0 ? static_cast<std::size_t>(st.st_size) : 0;
+        if (file_size_ == 0)
+        {
+            layout_ = LogLayout::for_format(options_.format);
+            if (layout_.format == LogFormat::v2)
+            {
+                LogFileHeader header = make_log_header(sensor_id_);
+                write_all(reinterpret_cast<const char *>(&header), sizeof(header));
+            }
+            return open_segments() && open_index() && open_rollups();
+        }
+
+        char header[sizeof(LogFileHeader)];
+        ssize_t header_size = ::pread(fd_, header, sizeof(header), 0);
+        if (header_size < 0 || !detect_log_layout(header, static_cast<std::size_t>(header_size), file_size_, layout_))
+        {
+            std::cerr << "Error: Unrecognized log file header for sensor " << sensor_id_ << std::endl;
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        return open_segments() && open_index() && open_rollups();
+    }
+
+    // Deve ser chamada com mutex_ adquirido. Segmentos existentes são lidos
+    // mesmo com a compressão desativada. Se o servidor parou entre gravar um
+    // bloco e truncar o log, o log contém exatamente o último bloco e é
+    // truncado aqui.
+    bool open_segments()
+    {
+        if (!segments_.open(segment_path(), options_.segment_records > 0))
+        {
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        if (segments_.blocks().empty())
+        {
+            return true;
+        }
+
+        const SegmentBlockHeader &last = segments_.blocks().back().header;
+        const std::size_t raw_records = layout_.record_count(file_size_);
+        if (raw_records == last.count && map_file() &&
+            raw_time_range(raw_records) == std::make_pair(last.min_timestamp, last.max_timestamp))
+        {
+            truncate_log();
+        }
+        return true;
+    }
+
+    // Deve ser chamada com mutex_ adquirido e o log mapeado. Menor e maior
+    // timestamp dos registros do log: o primeiro e o último, se as leituras
+    // chegaram em ordem.
+    std::pair<std::int64_t, std::int64_t> raw_time_range(std::size_t raw_records)
+    {
+        std::pair<std::int64_t, std::int64_t> range(layout_.decode(mapping_.data(), 0).timestamp,
+                                                     layout_.decode(mapping_.data(), raw_records - 1).timestamp);
+        if (index_.ordered() && range.first <= range.second)
+        {
+            return range;
+        }
+        for (std::size_t i = 0; i < raw_records; ++i)
+        {
+            const std::int64_t timestamp = layout_.decode(mapping_.data(), i).timestamp;
+            range.first = std::min(range.first, timestamp);
+            range.second = std::max(range.second, timestamp);
+        }
+        return range;
+    }
+
+    // Deve ser chamada com mutex_ adquirido. Sem o índice as consultas por
+    // intervalo continuam corretas, apenas varrem o log desde o início.
+    bool open_index()
+    {
+        const std::size_t raw_records = layout_.record_count(file_size_);
+        if (raw_records > 0 && !map_file())
+        {
+            return true;
+        }
+        index_.open(index_path(), options_.index_interval, raw_records, [this](std::size_t i)
+                    { return static_cast<std::int64_t>(layout_.decode(mapping_.data(), i).timestamp); });
+        return true;
+    }
+
+    // Deve ser chamada com mutex_ adquirido. Um nível que não cobre todas as
+    // leituras gravadas (servidor interrompido, ou criado agora para um
+    // sensor existente) é recalculado a partir do log. Sem os agregados as
+    // consultas AGG continuam corretas, apenas leem todas as leituras.
+    bool open_rollups()
+    {
+        if (!options_.rollups)
+        {
+            return true;
+        }
+
+        const std::uint64_t stored = stored_records();
+        std::vector<RollupFile *> stale;
+        for (std::size_t i = 0; i < rollup_tier_count; ++i)
+        {
+            std::uint64_t covered = 0;
+            if (!rollups_[i].open(rollup_path(rollup_tiers[i]), rollup_tiers[i], covered))
+            {
+                return true;
+            }
+            if (covered != stored && rollups_[i].reset())
+            {
+                stale.push_back(&rollups_[i]);
+            }
+        }
+        if (!stale.empty())
+        {
+            std::cerr << "Rebuilding rollups for sensor " << sensor_id_ << std::endl;
+            scan_stored(std::numeric_limits<std::time_t>::min(), std::numeric_limits<std::time_t>::max(),
+                        [&stale](const Reading *readings, std::size_t count)
+                        {
+                            for (RollupFile *rollup : stale)
+                            {
+                                for (std::size_t i = 0; i < count; ++i)
+                                {
+                                    rollup->add(readings[i]);
+                                }
+                            }
+                        });
+            for (RollupFile *rollup : stale)
+            {
+                rollup->persist(stored);
+            }
+        }
+        rollups_open_ = true;
+        return true;
+    }
+
+    // Deve ser chamada com mutex_ adquirido. Remove os registros do log,
+    // mantendo o cabeçalho.
+    void truncate_log()
+    {
+        if (::ftruncate(fd_, static_cast<off_t>(layout_.data_offset)) != 0)
+        {
+            std::cerr << "Error: Could not truncate log file for sensor " << sensor_id_
+                      << ": " << std::strerror(errno) << std::endl;
+            return;
+        }
+        file_size_ = std::min(file_size_, layout_.data_offset);
+        index_.clear();
+    }
+
+    // Deve ser chamada com mutex_ adquirido. Registros gravados (selados e
+    // no log), sem contar o lote pendente.
+    std::size_t stored_records() const
+    {
+        return segments_.records() + layout_.record_count(file_size_);
+    }
+
+    // Deve ser chamada com mutex_ adquirido. Copia para `readings` as
+    // últimas `count` leituras gravadas: primeiro dos blocos selados, depois
+    // do log mapeado.
+    bool read_stored(std::size_t count, std::vector<Reading> &readings)
+    {
+        readings.clear();
+        const std::size_t raw_records = layout_.record_count(file_size_);
+        const std::size_t from_log = std::min(count, raw_records);
+        if (count > from_log && !segments_.read_last(count - from_log, readings))
+        {
+            return false;
+        }
+        if (from_log == 0)
+        {
+            return true;
+        }
+        if (!map_file())
+        {
+            return false;
+        }
+
+        const std::size_t base = readings.size();
+        readings.resize(base + from_log);
+        const std::size_t first = raw_records - from_log;
+        for (std::size_t i = 0; i < from_log; ++i)
+        {
+            readings[base + i] = layout_.decode(mapping_.data(), first + i);
+        }
+        return true;
+    }
+
+    // Deve ser chamada com mutex_ adquirido. Sela os registros do log em um
+    // bloco comprimido assim que atingem options_.segment_records.
+    void seal_if_full()
+    {
+        const std::size_t raw_records = layout_.record_count(file_size_);
+        if (options_.segment_records == 0 || raw_records < options_.segment_records || !segments_.is_open())
+        {
+            return;
+        }
+
+        std::vector<Reading> readings;
+        if (!read_stored(raw_records, readings) ||
+            !segments_.append(readings.data(), readings.size(), options_.durability == Durability::fdatasync))
+        {
+            return;
+        }
+        truncate_log();
+    }
+
+#ifdef DAS_IO_URING
+    // Deve ser chamada com mutex_ adquirido, com o resultado da escrita do
+    // lote submetida por flush_batch (bytes escritos ou -errno). O que não
+    // foi escrito é gravado com write(2), que também relata o erro.
+    void complete_write(int result)
+    {
+        const std::size_t stored_size = file_size_;
+        const std::size_t written = result > 0 ? static_cast<std::size_t>(result) : 0;
+        file_size_ += written;
+        if (written < pending_.size() && !write_all(pending_.data() + written, pending_.size() - written) && wal_)
+        {
+            keep_pending(stored_size);
+            return;
+        }
+        finish_pending();
+    }
+#endif
+
+    // Deve ser chamada com mutex_ adquirido
+    bool write_all(const char *data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t written = ::write(fd_, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                std::cerr << "Error: Could not write log file for sensor " << sensor_id_
+                          << ": " << std::strerror(errno) << std::endl;
+                return false;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+            file_size_ += static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+    // Deve ser chamada com mutex_ adquirido
+    bool map_file()
+    {
+        if (!mapping_.ensure(fd_, file_size_))
+        {
+            std::cerr << "Error: Could not map log file for sensor " << sensor_id_
+                      << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Deve ser chamada com mutex_ adquirido. No primeiro uso do sensor o
+    // cache é preenchido com o fim do arquivo de log existente.
+    void warm_cache()
+    {
+        if (cache_warm_)
+        {
+            return;
+        }
+        cache_warm_ = true;
+        if (cache_.capacity() == 0 || !open_file())
+        {
+            return;
+        }
+
+        std::vector<Reading> readings;
+        if (!read_stored(std::min(stored_records(), cache_.capacity()), readings))
+        {
+            return;
+        }
+        for (const Reading &reading : readings)
+        {
+            cache_.push(reading);
+        }
+    }
+
+    // Deve ser chamada com mutex_ adquirido. Sem WAL, um lote que não pôde
+    // ser gravado é descartado; com WAL ele continua pendente, pois o WAL
+    // só é removido depois que os lotes chegam aos arquivos.
+    void write_pending()
+    {
+        if (pending_.empty())
+        {
+            return;
+        }
+
+        if (!open_file())
+        {
+            if (!wal_)
+            {
+                pending_.clear();
+            }
+            return;
+        }
+
+        const std::size_t stored_size = file_size_;
+        if (!write_all(pending_.data(), pending_.size()) && wal_)
+        {
+            keep_pending(stored_size);
+            return;
+        }
+        finish_pending();
+    }
+
+    // Deve ser chamada com mutex_ adquirido, depois de uma gravação do lote
+    // que falhou. Desfaz a parte gravada para que o lote inteiro seja
+    // gravado de novo na próxima tentativa.
+    void keep_pending(std::size_t stored_size)
+    {
+        if (file_size_ != stored_size && ::ftruncate(fd_, static_cast<off_t>(stored_size)) != 0)
+        {
+            std::cerr << "Error: Could not truncate log file for sensor " << sensor_id_
+                      << ": " << std::strerror(errno) << std::endl;
+        }
+        file_size_ = stored_size;
+    }
+
+    // Deve ser chamada com mutex_ adquirido, depois que o lote pendente foi
+    // entregue ao kernel
+    void finish_pending()
+    {
+        if (options_.durability == Durability::fdatasync)
+        {
+            ::fdatasync(fd_);
+        }
+        pending_.clear();
+        summary_.records = stored_records();
+        if (catalog_)
+        {
+            catalog_->update(catalog_handle_, summary_);
+        }
+        index_.flush();
+        if (rollups_open_)
+        {
+            for (RollupFile &rollup : rollups_)
+            {
+                rollup.persist(stored_records());
+            }
+        }
+        seal_if_full();
+    }
+
+    const std::string sensor_id_;
+    const StoreOptions &options_;
+    const std::uint32_t handle_;
+    OpenFileCache *const open_files_;
+    SensorCatalog *const catalog_;
+    const std::uint32_t catalog_handle_;
+    SensorSummary summary_; // min/max dos timestamps e leituras gravadas
+    WriteAheadLog *const wal_; // nullptr: lotes gravados direto nos arquivos
+    DirtyList *const dirty_;   // nullptr: sensor fora da lista de lotes pendentes
+    std::mutex mutex_;
+    int fd_ = -1;
+    bool opened_before_ = false; // para contar reaberturas
+    LogLayout layout_;
+    std::size_t file_size_ = 0; // bytes já entregues ao kernel
+    MappedFile mapping_;
+    SegmentFile segments_;
+    TimeIndex index_;
+    RollupFile rollups_[rollup_tier_count];
+    bool rollups_open_ = false;
+    RingBuffer<Reading> cache_; // últimas leituras, inclusive as ainda pendentes
+    bool cache_warm_ = false;
+    std::vector<char> pending_;
+    std::chrono::steady_clock::time_point pending_since_;
+    bool queued_ = false; // presente na lista de lotes pendentes (dirty_)
+};
+
+inline void OpenFileCache::opened(SensorLog &log, bool reopen)
+{
+    if (reopen)
+    {
+        reopens_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (capacity_ == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ring_.push_back(&log);
+    // Sensores em uso (mutex ocupado) são pulados; se todos estiverem em
+    // uso o limite é excedido temporariamente
+    for (std::size_t steps = 2 * ring_.size(); ring_.size() > capacity_ && steps > 0; --steps)
+    {
+        if (hand_ >= ring_.size())
+        {
+            hand_ = 0;
+        }
+        SensorLog *victim = ring_[hand_];
+        if (victim != &log && !victim->referenced.exchange(false, std::memory_order_relaxed) &&
+            victim->try_close_files())
+        {
+            ring_[hand_] = ring_.back();
+            ring_.pop_back();
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        ++hand_;
+    }
+}
+
+// Tabela handle -> SensorLog lida sem locks nem hashing. Os handles são
+// atribuídos em sequência e a tabela cresce em blocos que nunca são movidos,
+// então uma entrada publicada continua válida enquanto a tabela existir.
+class SensorTable
+{
+public:
+    static constexpr std::size_t chunk_bits = 12;
+    static constexpr std::size_t chunk_size = std::size_t(1) << chunk_bits;
+    static constexpr std::size_t max_chunks = 16384; // até 67 milhões de sensores
+
+    SensorTable() : chunks_(new std::atomic<Entry *>[max_chunks]()) {}
+
+    ~SensorTable()
+    {
+        for (std::size_t i = 0; i < max_chunks; ++i)
+        {
+            delete[] chunks_[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    SensorTable(const SensorTable &) = delete;
+    SensorTable &operator=(const SensorTable &) = delete;
+
+    // Reserva o próximo handle, alocando seu bloco se necessário
+    std::uint32_t reserve()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const std::size_t handle = size_;
+        if (handle >= max_chunks * chunk_size)
+        {
+            throw std::length_error("too many sensors");
+        }
+        std::atomic<Entry *> &chunk = chunks_[handle >> chunk_bits];
+        if (!chunk.load(std::memory_order_relaxed))
+        {
+            chunk.store(new Entry[chunk_size](), std::memory_order_release);
+        }
+        ++size_;
+        return static_cast<std::uint32_t>(handle);
+    }
+
+    void publish(std::uint32_t handle, SensorLog *log)
+    {
+        entry(handle).store(log, std::memory_order_release);
+    }
+
+    // O handle deve ter sido obtido de um SensorLog registrado
+    SensorLog &at(std::uint32_t handle) const
+    {
+        return *entry(handle).load(std::memory_order_acquire);
+    }
+
+private:
+    using Entry = std::atomic<SensorLog *>;
+
+    Entry &entry(std::uint32_t handle) const
+    {
+        return chunks_[handle >> chunk_bits].load(std::memory_order_acquire)[handle & (chunk_size - 1)];
+    }
+
+    std::mutex mutex_;
+    std::size_t size_ = 0;
+    std::unique_ptr<std::atomic<Entry *>[]> chunks_;
+};
+
+// Registro de SensorLogs particionado em shards. O mutex de um shard só é
+// mantido durante a busca no mapa, compartilhado entre as buscas e exclusivo
+// apenas para registrar um sensor novo; abertura e escrita usam o mutex do
+// sensor. Os sensores do catálogo são registrados na inicialização.
+// Os SensorLogs nunca são removidos, então os ponteiros retornados são estáveis;
+// apenas seus arquivos são fechados pelo OpenFileCache.
+//
+// Uma thread de flush grava os lotes cuja idade excede a janela configurada
+// (exceto com Durability::none, em que os lotes só são gravados ao encher).
+//
+// Com StorageEngine::wal, a mesma thread entrega o WAL ao kernel pela janela
+// de flush e, quando ele atinge wal_bytes, o compacta: começa um WAL novo,
+// grava de uma vez o lote de cada sensor, torna os arquivos duráveis e
+// remove o WAL anterior. WALs deixados por uma interrupção são reaplicados
+// na inicialização.
+class LogStore
+{
+public:
+    struct Stats
+    {
+        std::uint64_t cache_hits = 0;   // consultas atendidas pelo cache em memória
+        std::uint64_t cache_misses = 0; // consultas que precisaram ler o arquivo
+        std::uint64_t rollup_queries = 0; // consultas AGG atendidas com agregados pré-calculados
+        std::size_t open_sensors = 0;     // sensores com arquivos abertos
+        std::uint64_t sensor_evictions = 0; // sensores fechados para respeitar max_open_sensors
+        std::uint64_t sensor_reopens = 0;   // sensores que reabriram os arquivos após serem fechados
+        std::uint64_t wal_compactions = 0;  // compactações do WAL nos arquivos dos sensores
+    };
+
+    explicit LogStore(const StoreOptions &options = StoreOptions(), std::size_t num_shards = 64)
+        : options_(options), num_shards_(num_shards), open_files_(options_.max_open_sensors),
+          shards_(new Shard[num_shards])
+    {
+#ifdef DAS_IO_URING
+        if (!ring_.is_open())
+        {
+            std::cerr << "Warning: io_uring is unavailable (" << std::strerror(ring_.error())
+                      << "); writing batches with write(2)" << std::endl;
+        }
+#endif
+
+        // Sensores de execuções anteriores são registrados sem abrir arquivos.
+        // O WAL identifica os sensores pelo handle do catálogo e depende dele.
+        if (!options_.catalog_path.empty() && catalog_.open(options_.catalog_path))
+        {
+            if (options_.storage == StorageEngine::wal)
+            {
+                wal_ = std::make_unique<WriteAheadLog>(options_.durability == Durability::fdatasync);
+            }
+            std::vector<SensorLog *> by_catalog_handle;
+            for (const SensorCatalog::Sensor &sensor : catalog_.sensors())
+            {
+                by_catalog_handle.push_back(
+                    &register_sensor(shard_for(sensor.sensor_id), sensor.sensor_id, sensor.handle, sensor.summary));
+            }
+            catalog_.release_sensors();
+            if (wal_)
+            {
+                recover_wal(by_catalog_handle);
+            }
+        }
+        else if (options_.storage == StorageEngine::wal)
+        {
+            std::cerr << "Warning: The write-ahead log requires the sensor catalog; writing directly to sensor files"
+                      << std::endl;
+        }
+
+        if (options_.durability != Durability::none || wal_)
+        {
+            flusher_ = std::thread([this]
+                                   { flush_loop(); });
+        }
+    }
+
+    ~LogStore()
+    {
+        {
+            std::lock_guard<std::mutex> lock(dirty_.mutex);
+            stopping_ = true;
+        }
+        dirty_.cv.notify_one();
+        if (flusher_.joinable())
+        {
+            flusher_.join();
+        }
+        if (wal_)
+        {
+            compact(false);
+        }
+    }
+
+    LogStore(const LogStore &) = delete;
+    LogStore &operator=(const LogStore &) = delete;
+
+    void append(std::string_view sensor_id, const Reading &reading)
+    {
+        append(get_or_create(sensor_id), reading);
+    }
+
+    void append(SensorLog &log, const Reading &reading)
+    {
+        append(log, &reading, 1);
+    }
+
+    void append(SensorLog &log, const Reading *readings, std::size_t count)
+    {
+        log.append(readings, count);
+    }
+
+    SensorLog &get_or_create(std::string_view sensor_id)
+    {
+        Shard &shard = shard_for(sensor_id);
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.logs.find(sensor_id);
+            if (it != shard.logs.end())
+            {
+                return *it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.logs.find(sensor_id);
+        if (it != shard.logs.end())
+        {
+            return *it->second;
+        }
+        return register_sensor(shard, sensor_id, catalog_.add(sensor_id), SensorSummary());
+    }
+
+    // Handle do sensor, registrando-o se necessário. Quem guarda o handle
+    // acessa o sensor com at(), sem hashing do id.
+    std::uint32_t intern(std::string_view sensor_id)
+    {
+        return get_or_create(sensor_id).handle();
+    }
+
+    SensorLog &at(std::uint32_t handle) const
+    {
+        return sensors_.at(handle);
+    }
+
+    bool read_last(SensorLog &log, std::size_t count, std::vector<Reading> &readings)
+    {
+        bool from_cache = false;
+        bool ok = log.read_last(count, readings, from_cache);
+        (from_cache ? cache_hits_ : cache_misses_).fetch_add(1, std::memory_order_relaxed);
+        return ok;
+    }
+
+    bool read_range(SensorLog &log, std::time_t from, std::time_t to, std::vector<Reading> &readings)
+    {
+        return log.read_range(from, to, readings);
+    }
+
+    bool aggregate(SensorLog &log, std::time_t from, std::time_t to, Aggregator &aggregator)
+    {
+        bool used_rollups = false;
+        bool ok = log.aggregate(from, to, aggregator, used_rollups);
+        if (used_rollups)
+        {
+            rollup_queries_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return ok;
+    }
+
+    Stats stats() const
+    {
+        Stats stats;
+        stats.cache_hits = cache_hits_.load(std::memory_order_relaxed);
+        stats.cache_misses = cache_misses_.load(std::memory_order_relaxed);
+        stats.rollup_queries = rollup_queries_.load(std::memory_order_relaxed);
+        stats.open_sensors = open_files_.open_count();
+        stats.sensor_evictions = open_files_.evictions();
+        stats.sensor_reopens = open_files_.reopens();
+        stats.wal_compactions = wal_compactions_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // Retorna nullptr se o sensor é desconhecido
+    SensorLog *find(std::string_view sensor_id)
+    {
+        Shard &shard = shard_for(sensor_id);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.logs.find(sensor_id);
+        return it == shard.logs.end() ? nullptr : it->second.get();
+    }
+
+    bool contains(std::string_view sensor_id)
+    {
+        return find(sensor_id) != nullptr;
+    }
+
+private:
+    struct alignas(64) Shard // evita false sharing entre mutexes de shards vizinhos
+    {
+        std::shared_mutex mutex; // exclusivo apenas para registrar um sensor novo
+        std::unordered_map<std::string_view, std::unique_ptr<SensorLog>> logs;
+    };
+
+    // Deve ser chamada com o mutex do shard adquirido em modo exclusivo
+    SensorLog &register_sensor(Shard &shard, std::string_view sensor_id, std::uint32_t catalog_handle,
+                               const SensorSummary &summary)
+    {
+        SensorLogContext context;
+        context.handle = sensors_.reserve();
+        context.open_files = &open_files_;
+        context.catalog = &catalog_;
+        context.catalog_handle = catalog_handle;
+        context.summary = summary;
+        context.wal = wal_.get();
+        context.dirty = &dirty_;
+        auto log = std::make_unique<SensorLog>(std::string(sensor_id), options_, context);
+        sensors_.publish(context.handle, log.get());
+        // A chave aponta para o id mantido pelo próprio SensorLog
+        std::string_view key = log->sensor_id();
+        return *shard.logs.emplace(key, std::move(log)).first->second;
+    }
+
+    Shard &shard_for(std::string_view sensor_id)
+    {
+        return shards_[std::hash<std::string_view>{}(sensor_id) % num_shards_];
+    }
+
+    void flush_loop()
+    {
+        auto tick = std::max(options_.flush_window / 2, std::chrono::milliseconds(1));
+        std::unique_lock<std::mutex> lock(dirty_.mutex);
+        while (!stopping_)
+        {
+            dirty_.cv.wait_for(lock, tick);
+
+            std::vector<SensorLog *> dirty;
+            dirty.swap(dirty_.logs);
+            lock.unlock();
+
+            auto cutoff = std::chrono::steady_clock::now() - options_.flush_window;
+            std::vector<SensorLog *> still_pending;
+            std::vector<SensorLog *> due;
+            for (SensorLog *log : dirty)
+            {
+                (log->uses_wal() ? still_pending : due).push_back(log);
+            }
+            flush_sensors(due, cutoff, still_pending);
+            if (wal_ && options_.durability != Durability::none)
+            {
+                wal_->flush_if_older(cutoff);
+            }
+
+            lock.lock();
+            dirty_.logs.insert(dirty_.logs.end(), still_pending.begin(), still_pending.end());
+            if (wal_ && wal_->size() >= options_.wal_bytes)
+            {
+                lock.unlock();
+                compact(true);
+                lock.lock();
+            }
+        }
+    }
+
+    // Grava os lotes anteriores a cutoff; os sensores que ainda têm dados
+    // pendentes vão para `still_pending`
+    void flush_sensors(const std::vector<SensorLog *> &logs, std::chrono::steady_clock::time_point cutoff,
+                       std::vector<SensorLog *> &still_pending)
+    {
+#ifdef DAS_IO_URING
+        if (ring_.is_open())
+        {
+            SensorLog::flush_batch(ring_, logs, cutoff, still_pending);
+            return;
+        }
+#endif
+        for (SensorLog *log : logs)
+        {
+            if (log->flush_if_older(cutoff))
+            {
+                still_pending.push_back(log);
+            }
+        }
+    }
+
+    // Grava nos arquivos dos sensores os lotes de todas as leituras do WAL
+    // atual e o remove. As leituras recebidas durante a compactação vão para
+    // o WAL seguinte (com `reopen`) e podem ser gravadas junto; ao reaplicar
+    // esse WAL elas são reconhecidas pelo número e ignoradas. Se algum lote
+    // não pôde ser gravado, o WAL é mantido e os sensores voltam para a
+    // lista, até uma compactação em que todos os lotes sejam gravados.
+    void compact(bool reopen)
+    {
+        const std::string previous = reopen ? wal_->rotate() : wal_->close();
+        if (!previous.empty())
+        {
+            retained_wals_.push_back(previous);
+        }
+        std::vector<SensorLog *> dirty;
+        {
+            std::lock_guard<std::mutex> lock(dirty_.mutex);
+            dirty.swap(dirty_.logs);
+        }
+        std::vector<SensorLog *> still_pending;
+        flush_sensors(dirty, std::chrono::steady_clock::time_point::max(), still_pending);
+        WriteAheadLog::sync_filesystem();
+        if (!still_pending.empty())
+        {
+            std::cerr << "Error: Could not write batches for " << still_pending.size()
+                      << " sensors; keeping write-ahead log " << previous << std::endl;
+            std::lock_guard<std::mutex> lock(dirty_.mutex);
+            dirty_.logs.insert(dirty_.logs.end(), still_pending.begin(), still_pending.end());
+            return;
+        }
+        remove_retained_wals();
+        wal_compactions_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // WALs cujas leituras já estão nos arquivos dos sensores
+    void remove_retained_wals()
+    {
+        for (const std::string &file : retained_wals_)
+        {
+            ::unlink(file.c_str());
+        }
+        retained_wals_.clear();
+    }
+
+    // Reaplica os WALs deixados pela execução anterior e os remove depois
+    // de gravar e tornar duráveis os lotes resultantes
+    void recover_wal(const std::vector<SensorLog *> &by_catalog_handle)
+    {
+        const std::vector<std::string> files = WriteAheadLog::existing_files();
+        const unsigned long next = files.empty() ? 1 : std::strtoul(files.back().c_str(), nullptr, 10) + 1;
+        wal_->open(next);
+        if (files.empty())
+        {
+            return;
+        }
+
+        std::size_t records = 0;
+        std::size_t skipped = 0;
+        std::vector<bool> reported(by_catalog_handle.size(), false);
+        for (const std::string &file : files)
+        {
+            WriteAheadLog::replay(file, [&](const WalRecord &record)
+                                  {
+                                      if (record.sensor >= by_catalog_handle.size())
+                                      {
+                                          return;
+                                      }
+                                      SensorLog &log = *by_catalog_handle[record.sensor];
+                                      if (log.replay(record))
+                                      {
+                                          ++records;
+                                          return;
+                                      }
+                                      // Reaplicar depois de uma lacuna deslocaria a
+                                      // numeração das leituras do sensor
+                                      ++skipped;
+                                      if (!reported[record.sensor])
+                                      {
+                                          reported[record.sensor] = true;
+                                          std::cerr << "Error: Gap in write-ahead log sequence for sensor "
+                                                    << log.sensor_id() << " at reading " << record.sequence
+                                                    << "; skipping the following records" << std::endl;
+                                      }
+                                  });
+        }
+        std::vector<SensorLog *> still_pending;
+        flush_sensors(by_catalog_handle, std::chrono::steady_clock::time_point::max(), still_pending);
+        WriteAheadLog::sync_filesystem();
+        retained_wals_ = files;
+        dirty_.logs.swap(still_pending);
+        if (dirty_.logs.empty())
+        {
+            remove_retained_wals();
+        }
+        else
+        {
+            std::cerr << "Error: Could not write replayed batches for " << dirty_.logs.size()
+                      << " sensors; keeping write-ahead logs" << std::endl;
+        }
+        std::cerr << "Replayed " << records << " records from " << files.size() << " write-ahead log files";
+        if (skipped > 0)
+        {
+            std::cerr << " (" << skipped << " skipped after sequence gaps)";
+        }
+        std::cerr << std::endl;
+    }
+
+    const StoreOptions options_;
+    const std::size_t num_shards_;
+    OpenFileCache open_files_; // destruído depois dos SensorLogs
+    SensorCatalog catalog_;
+    std::unique_ptr<WriteAheadLog> wal_; // nullptr: StorageEngine::files
+    SensorTable sensors_;
+    std::unique_ptr<Shard[]> shards_;
+
+    DirtyList dirty_;                       // sensores com lote pendente
+    std::vector<std::string> retained_wals_; // WALs mantidos após gravações que falharam
+    bool stopping_ = false;
+    std::thread flusher_;
+#ifdef DAS_IO_URING
+    IoUring ring_; // usado apenas pela thread de flush (e pela compactação final)
+#endif
+
+    std::atomic<std::uint64_t> cache_hits_{0};
+    std::atomic<std::uint64_t> cache_misses_{0};
+    std::atomic<std::uint64_t> rollup_queries_{0};
+    std::atomic<std::uint64_t> wal_compactions_{0};
+};
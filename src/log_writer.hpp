@@ -0,0 +1,320 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "log_record.hpp"
+#include "log_store.hpp"
+#include "mpsc_queue.hpp"
+
+struct WriterOptions
+{
+    std::size_t threads = 1;            // 0 = escrita síncrona na thread de rede
+    std::size_t queue_capacity = 65536; // registros por fila (uma fila por thread)
+};
+
+// Retira a escrita em disco das threads de rede: as sessões enfileiram as
+// leituras e threads dedicadas os entregam ao LogStore. Cada sensor é
+// sempre atendido pela mesma fila, preservando a ordem dos seus registros.
+// Nenhuma operação espera pelas threads de escrita: com a fila cheia, ou
+// para consultar registros ainda na fila, a sessão registra uma função que
+// a thread de escrita chama quando puder continuar.
+class LogWriter
+{
+public:
+    struct Stats
+    {
+        std::size_t queue_depth = 0;
+        std::size_t queue_capacity = 0;
+        std::uint64_t enqueued = 0;
+        std::uint64_t written = 0;
+        std::uint64_t queue_full = 0; // enfileiramentos que encontraram a fila cheia
+        std::uint64_t enqueue_avg_ns = 0;
+        std::uint64_t enqueue_max_ns = 0;
+    };
+
+    LogWriter(LogStore &logs, const WriterOptions &options)
+        : logs_(logs)
+    {
+        for (std::size_t i = 0; i < options.threads; ++i)
+        {
+            workers_.push_back(std::make_unique<Worker>(options.queue_capacity));
+        }
+        for (auto &worker : workers_)
+        {
+            worker->thread = std::thread([this, w = worker.get()]
+                                         { run(*w); });
+        }
+    }
+
+    ~LogWriter()
+    {
+        for (auto &worker : workers_)
+        {
+            {
+                std::lock_guard<std::mutex> lock(worker->mutex);
+                worker->stopping = true;
+            }
+            worker->cv.notify_one();
+            worker->thread.join();
+        }
+    }
+
+    LogWriter(const LogWriter &) = delete;
+    LogWriter &operator=(const LogWriter &) = delete;
+
+    // Enfileira um lote de leituras do mesmo sensor e retorna quantas foram
+    // aceitas; a latência medida é a do lote inteiro. Com a fila cheia o
+    // restante deve ser reenviado depois que when_space avisar.
+    std::size_t enqueue(SensorLog &log, const Reading *readings, std::size_t count)
+    {
+        if (workers_.empty())
+        {
+            logs_.append(log, readings, count);
+            enqueued_.fetch_add(count, std::memory_order_relaxed);
+            written_.fetch_add(count, std::memory_order_relaxed);
+            return count;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        Worker &worker = worker_for(log);
+        std::size_t accepted = 0;
+        while (accepted < count && worker.queue.try_push(Item{&log, readings[accepted]}))
+        {
+            ++accepted;
+        }
+        if (accepted < count)
+        {
+            queue_full_.fetch_add(1, std::memory_order_relaxed);
+            wake(worker);
+        }
+        // A thread de escrita acorda sozinha a cada 1 ms; só é acordada antes
+        // disso quando a fila começa a encher, evitando uma troca de contexto
+        // por registro.
+        if (worker.queue.size() >= worker.wake_threshold && worker.sleeping.load(std::memory_order_seq_cst))
+        {
+            wake(worker);
+        }
+
+        auto elapsed = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        enqueued_.fetch_add(accepted, std::memory_order_relaxed);
+        enqueue_ns_.fetch_add(elapsed, std::memory_order_relaxed);
+        std::uint64_t max = enqueue_max_ns_.load(std::memory_order_relaxed);
+        while (elapsed > max && !enqueue_max_ns_.compare_exchange_weak(max, elapsed, std::memory_order_relaxed))
+        {
+        }
+        return accepted;
+    }
+
+    // Chama done, na thread de escrita, quando todos os registros já
+    // enfileirados para o sensor tiverem sido entregues ao LogStore (usado
+    // antes de responder consultas). Retorna false, sem chamar done, se não
+    // há registros pendentes.
+    bool when_written(const SensorLog &log, std::function<void()> done)
+    {
+        if (workers_.empty())
+        {
+            return false;
+        }
+        Worker &worker = worker_for(log);
+        return add_waiter(worker, worker.queue.enqueued(), done);
+    }
+
+    // Chama done quando a fila do sensor estiver pela metade, depois de um
+    // enqueue que não coube: na thread de escrita ou, se a fila já tiver
+    // esvaziado, imediatamente
+    void when_space(const SensorLog &log, std::function<void()> done)
+    {
+        if (workers_.empty())
+        {
+            done();
+            return;
+        }
+        Worker &worker = worker_for(log);
+        const std::uint64_t enqueued = worker.queue.enqueued();
+        const std::uint64_t half = worker.queue.capacity() / 2;
+        if (!add_waiter(worker, enqueued > half ? enqueued - half : 0, done))
+        {
+            done();
+        }
+    }
+
+    Stats stats() const
+    {
+        Stats stats;
+        for (const auto &worker : workers_)
+        {
+            stats.queue_depth += worker->queue.size();
+            stats.queue_capacity += worker->queue.capacity();
+        }
+        stats.enqueued = enqueued_.load(std::memory_order_relaxed);
+        stats.written = written_.load(std::memory_order_relaxed);
+        stats.queue_full = queue_full_.load(std::memory_order_relaxed);
+        stats.enqueue_avg_ns = stats.enqueued ? enqueue_ns_.load(std::memory_order_relaxed) / stats.enqueued : 0;
+        stats.enqueue_max_ns = enqueue_max_ns_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct Item
+    {
+        SensorLog *log;
+        Reading reading;
+    };
+
+    // Função a chamar quando processed alcançar target
+    struct Waiter
+    {
+        std::uint64_t target;
+        std::function<void()> done;
+    };
+
+    struct Worker
+    {
+        explicit Worker(std::size_t capacity)
+            : queue(capacity), wake_threshold(std::max<std::size_t>(1, queue.capacity() / 16)) {}
+
+        MpscQueue<Item> queue;
+        const std::size_t wake_threshold;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::atomic<bool> sleeping{false};
+        std::atomic<std::uint64_t> processed{0}; // registros já entregues ao LogStore
+        std::atomic<std::size_t> num_waiters{0};
+        std::vector<Waiter> waiters; // protegido por mutex
+        bool stopping = false;
+        std::thread thread;
+    };
+
+    Worker &worker_for(const SensorLog &log)
+    {
+        return *workers_[std::hash<const SensorLog *>{}(&log) % workers_.size()];
+    }
+
+    static void wake(Worker &worker)
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.cv.notify_one();
+    }
+
+    // Retorna false se processed já alcançou target. processed e
+    // num_waiters são seq_cst: ou a sessão vê o progresso, ou a thread de
+    // escrita vê o novo waiter. done só é consumida se retornar true.
+    static bool add_waiter(Worker &worker, std::uint64_t target, std::function<void()> &done)
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.num_waiters.fetch_add(1, std::memory_order_seq_cst);
+        if (worker.processed.load(std::memory_order_seq_cst) >= target)
+        {
+            worker.num_waiters.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        worker.waiters.push_back(Waiter{target, std::move(done)});
+        worker.cv.notify_one();
+        return true;
+    }
+
+    // Chama, fora do lock, as funções cujos registros já foram entregues
+    static void notify_waiters(Worker &worker)
+    {
+        if (worker.num_waiters.load(std::memory_order_seq_cst) == 0)
+        {
+            return;
+        }
+        std::vector<std::function<void()>> ready;
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            const std::uint64_t processed = worker.processed.load(std::memory_order_relaxed);
+            auto pending = std::partition(worker.waiters.begin(), worker.waiters.end(),
+                                          [processed](const Waiter &waiter)
+                                          { return waiter.target > processed; });
+            for (auto it = pending; it != worker.waiters.end(); ++it)
+            {
+                ready.push_back(std::move(it->done));
+            }
+            worker.waiters.erase(pending, worker.waiters.end());
+            worker.num_waiters.store(worker.waiters.size(), std::memory_order_relaxed);
+        }
+        for (auto &done : ready)
+        {
+            done();
+        }
+    }
+
+    // Entrega ao LogStore as leituras acumuladas de um sensor
+    void deliver(Worker &worker, SensorLog *log, std::vector<Reading> &batch)
+    {
+        if (batch.empty())
+        {
+            return;
+        }
+        logs_.append(*log, batch.data(), batch.size());
+        worker.processed.store(worker.processed.load(std::memory_order_relaxed) + batch.size(), std::memory_order_seq_cst);
+        batch.clear();
+        notify_waiters(worker);
+    }
+
+    void run(Worker &worker)
+    {
+        // Registros consecutivos do mesmo sensor são entregues juntos, com um
+        // único lock do SensorLog
+        constexpr std::size_t max_batch = 256;
+        Item item;
+        std::vector<Reading> batch;
+        batch.reserve(max_batch);
+        SensorLog *batch_log = nullptr;
+        for (;;)
+        {
+            std::size_t drained = 0;
+            while (worker.queue.try_pop(item))
+            {
+                if (item.log != batch_log || batch.size() == max_batch)
+                {
+                    deliver(worker, batch_log, batch);
+                    batch_log = item.log;
+                }
+                batch.push_back(item.reading);
+                ++drained;
+            }
+            deliver(worker, batch_log, batch);
+            if (drained > 0)
+            {
+                written_.fetch_add(drained, std::memory_order_relaxed);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            if (worker.stopping)
+            {
+                if (worker.queue.size() == 0)
+                {
+                    return;
+                }
+                continue;
+            }
+            worker.sleeping.store(true, std::memory_order_seq_cst);
+            if (worker.queue.size() < worker.wake_threshold)
+            {
+                worker.cv.wait_for(lock, std::chrono::milliseconds(1));
+            }
+            worker.sleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    LogStore &logs_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<std::uint64_t> enqueued_{0};
+    std::atomic<std::uint64_t> written_{0};
+    std::atomic<std::uint64_t> queue_full_{0};
+    std::atomic<std::uint64_t> enqueue_ns_{0};
+    std::atomic<std::uint64_t> enqueue_max_ns_{0};
+};
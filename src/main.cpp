@@ -1,269 +1,732 @@
 #include <iostream>
-#include <fstream>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
 #include <boost/asio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <ctime>
-#include <iomanip>
 #include <sstream>
-#include <mutex> // Adicionado para std::mutex
+#include "aggregate.hpp"
+#include "binary_protocol.hpp"
+#include "io_context_pool.hpp"
+#include "log_record.hpp"
+#include "log_store.hpp"
+#include "log_writer.hpp"
+#include "options.hpp"
+#include "protocol.hpp"
+#include "read_buffer.hpp"
+#include "response_writer.hpp"
+#include "time_codec.hpp"
 
 using boost::asio::ip::tcp;
 
-#pragma pack(push, 1)
-struct LogRecord
+// Contadores de mensagens rejeitadas, compartilhados pelas sessões
+struct IngestStats
 {
-    char sensor_id[32];    // supondo um ID de sensor de até 32 caracteres
-    std::time_t timestamp; // timestamp UNIX
-    double value;          // valor da leitura
+    std::atomic<std::uint64_t> invalid_messages{0};
+    std::atomic<std::uint64_t> invalid_timestamps{0};
+    std::atomic<std::uint64_t> invalid_values{0};
 };
-#pragma pack(pop)
 
 class Session : public std::enable_shared_from_this<Session>
 {
 public:
-    Session(tcp::socket socket, std::unordered_map<std::string, std::ofstream> &logs, std::mutex &logs_mutex)
-        : socket_(std::move(socket)), logs_(logs), logs_mutex_(logs_mutex) {}
+    Session(tcp::socket socket, LogStore &logs, LogWriter &writer, const ServerOptions &options, IngestStats &stats)
+        : socket_(std::move(socket)), logs_(logs), writer_(writer), options_(options), stats_(stats),
+          timestamps_(options.time_zone) {}
 
     void start()
     {
-        read_message();
+        read_some();
     }
 
 private:
-    void read_message()
+    // Maior mensagem aceita: uma linha do protocolo texto ou um quadro binário
+    static constexpr std::size_t max_message_bytes = 2 << 20;
+    // Espaço livre pedido para cada leitura do socket: dobra enquanto as
+    // leituras enchem o buffer (há mais dados esperando) e volta ao mínimo
+    // quando o socket esvazia
+    static constexpr std::size_t min_read_bytes = 1024;
+    static constexpr std::size_t max_read_bytes = 64 * 1024;
+    // Registros de uma resposta GET; pedidos maiores recebem os últimos max_get_records
+    static constexpr int max_get_records = 100000;
+
+    enum class Protocol
+    {
+        unknown, // nada recebido ainda
+        text,
+        binary
+    };
+
+    // Lê o que estiver disponível no socket e processa de uma vez todas as
+    // mensagens completas recebidas: mensagens em pipeline no mesmo segmento
+    // TCP custam uma única operação assíncrona.
+    void read_some()
     {
+        if (!input_.prepare(std::max(input_missing_, read_size_)))
+        {
+            // A mensagem não cabe no buffer: responde e deixa de ler
+            reject(stats_.invalid_messages, "ERROR|INVALID_MESSAGE\r\n");
+            return;
+        }
         auto self(shared_from_this());
-        boost::asio::async_read_until(socket_, buffer_, "\r\n",
-                                      [this, self](boost::system::error_code ec, std::size_t length)
-                                      {
-                                          if (!ec)
-                                          {
-                                              std::istream is(&buffer_);
-                                              std::string message;
-                                              std::getline(is, message);
-                                              process_message(message);
-                                              read_message();
-                                          }
-                                      });
+        socket_.async_read_some(boost::asio::buffer(input_.free_space(), input_.free_size()),
+                                [this, self, offered = input_.free_size()](boost::system::error_code ec, std::size_t length)
+                                {
+                                    if (ec)
+                                    {
+                                        return;
+                                    }
+                                    input_.commit(length);
+                                    read_size_ = length == offered ? std::min(read_size_ * 2, max_read_bytes) : min_read_bytes;
+                                    if (protocol_ == Protocol::unknown)
+                                    {
+                                        // O primeiro byte da conexão escolhe o protocolo
+                                        const char first = input_.data().front();
+                                        protocol_ = static_cast<unsigned char>(first) == binary_magic ? Protocol::binary
+                                                                                                       : Protocol::text;
+                                    }
+                                    process_input();
+                                });
+    }
+
+    // Processa as mensagens completas do buffer e volta a ler o socket
+    void process_input()
+    {
+        if (protocol_ == Protocol::binary ? process_binary() : process_lines())
+        {
+            continue_reading();
+        }
+    }
+
+    // Respostas além de max_outbound_bytes, ou uma espera pelas threads de
+    // escrita, suspendem o processamento: as mensagens restantes ficam no
+    // buffer até a sessão poder continuar
+    bool outbox_full() const
+    {
+        return outbox_bytes_ > options_.max_outbound_bytes;
+    }
+
+    bool suspended() const
+    {
+        return outbox_full() || waiting_writer_;
+    }
+
+    // Retoma o processamento suspenso, começando pelas mensagens que ficaram
+    // no buffer
+    void resume()
+    {
+        if (reading_paused_ && !waiting_writer_ && outbox_bytes_ <= options_.max_outbound_bytes / 2)
+        {
+            reading_paused_ = false;
+            process_input();
+        }
     }
 
-    void process_message(const std::string &message)
+    // Processa as linhas completas do buffer, até a fila de respostas
+    // encher. Retorna false se a sessão deve deixar de ler.
+    bool process_lines()
     {
-        if (message.rfind("LOG|", 0) == 0)
+        for (;;)
         {
-            auto parts = split_message(message);
-            if (parts.size() == 4)
+            if (suspended())
             {
-                const std::string &sensor_id = parts[1];
-                const std::string &timestamp_str = parts[2]; // Renomeado para evitar conflito
-                const std::string &value_str = parts[3];     // Renomeado para evitar conflito
-
-                LogRecord record;
-                std::strncpy(record.sensor_id, sensor_id.c_str(), sizeof(record.sensor_id) - 1);
-                record.sensor_id[sizeof(record.sensor_id) - 1] = '\\0'; // Garantir terminação nula
-                record.timestamp = string_to_time_t(timestamp_str);
-                try
-                {
-                    record.value = std::stod(value_str);
-
-                    std::lock_guard<std::mutex> lock(logs_mutex_);
-                    if (logs_.find(sensor_id) == logs_.end())
-                    {
-                        logs_[sensor_id].open(sensor_id + ".log", std::ios::binary | std::ios::app);
-                    }
-
-                    if (logs_[sensor_id].is_open())
-                    {
-                        logs_[sensor_id].write(reinterpret_cast<const char *>(&record), sizeof(record));
-                        logs_[sensor_id].flush(); // Garantir que os dados sejam escritos imediatamente
-                    }
-                    else
-                    {
-                        // Opcional: Logar erro se o arquivo não pôde ser aberto
-                        std::cerr << "Error: Could not open log file for sensor " << sensor_id << std::endl;
-                    }
-                }
-                catch (const std::invalid_argument &ia)
+                return true;
+            }
+            std::string_view data = input_.data();
+            const void *newline = std::memchr(data.data(), '\n', data.size());
+            if (!newline)
+            {
+                input_missing_ = 1;
+                return true;
+            }
+            // A linha é lida diretamente do buffer de recepção, sem cópia
+            const std::size_t length = static_cast<const char *>(newline) - data.data() + 1;
+            process_message(strip_line_ending(data.substr(0, length)));
+            input_.consume(length);
+        }
+    }
+
+    // Consome a abertura e todos os quadros completos já recebidos; as
+    // leituras vão direto para a fila de escrita, sem conversão de texto
+    bool process_binary()
+    {
+        for (;;)
+        {
+            if (suspended())
+            {
+                return true;
+            }
+            std::string_view data = input_.data();
+            std::size_t length = 0;
+            BinaryStatus status;
+            if (!binary_log_)
+            {
+                std::string_view sensor_id;
+                status = parse_binary_hello(data, sensor_id, length);
+                if (status == BinaryStatus::complete)
                 {
-                    std::cerr << "Invalid argument: " << ia.what() << " for sensor_id: " << sensor_id << " value: " << value_str << std::endl;
-                    // Opcional: Enviar erro de volta ao cliente
+                    binary_log_ = &sensor(sensor_id);
                 }
-                catch (const std::out_of_range &oor)
+            }
+            else
+            {
+                std::string_view payload;
+                status = parse_binary_frame(data, payload, length);
+                if (status == BinaryStatus::complete)
                 {
-                    std::cerr << "Out of Range error: " << oor.what() << " for sensor_id: " << sensor_id << " value: " << value_str << std::endl;
-                    // Opcional: Enviar erro de volta ao cliente
+                    process_binary_frame(payload);
                 }
             }
+
+            if (status == BinaryStatus::invalid)
+            {
+                // Sem como ressincronizar o fluxo: responde e deixa de ler
+                reject(stats_.invalid_messages, "ERROR|INVALID_MESSAGE\r\n");
+                return false;
+            }
+            if (status == BinaryStatus::incomplete)
+            {
+                input_missing_ = length - data.size();
+                return true;
+            }
+            input_.consume(length);
+        }
+    }
+
+    void process_binary_frame(std::string_view payload)
+    {
+        if (payload.empty())
+        {
+            when_written(*binary_log_, [this, count = binary_readings_]
+                         {
+                             std::string ack(8, '\0');
+                             store_le64(count, &ack[0]);
+                             send(std::move(ack)); });
+            return;
         }
-        else if (message.rfind("GET|", 0) == 0)
+        batch_.clear();
+        for (std::size_t offset = 0; offset < payload.size(); offset += binary_reading_size)
         {
-            auto parts = split_message(message);
-            if (parts.size() == 3)
+            batch_.push_back(decode_binary_reading(payload.data() + offset));
+            if (!timestamp_in_range(batch_.back().timestamp))
             {
-                const std::string &sensor_id = parts[1];
-                int num_records = 0;
-                try
+                // O quadro inteiro é descartado, como uma mensagem LOGB
+                reject(stats_.invalid_timestamps, "ERROR|INVALID_TIMESTAMP\r\n");
+                return;
+            }
+        }
+        enqueue(*binary_log_, batch_.data(), batch_.size());
+        binary_readings_ += batch_.size();
+    }
+
+    // Entrega as leituras à fila de escrita do sensor. O que não couber na
+    // fila é guardado e a sessão fica suspensa até a thread de escrita
+    // liberar espaço: as mensagens seguintes continuam no buffer.
+    void enqueue(SensorLog &log, const Reading *readings, std::size_t count)
+    {
+        const std::size_t accepted = writer_.enqueue(log, readings, count);
+        if (accepted < count)
+        {
+            deferred_.assign(readings + accepted, readings + count);
+            deferred_log_ = &log;
+            waiting_writer_ = true;
+            wait_for_queue();
+        }
+    }
+
+    void wait_for_queue()
+    {
+        auto self(shared_from_this());
+        writer_.when_space(*deferred_log_, [this, self]
+                           { boost::asio::post(socket_.get_executor(), [this, self]
+                                               {
+                                                   const std::size_t accepted = writer_.enqueue(*deferred_log_, deferred_.data(), deferred_.size());
+                                                   deferred_.erase(deferred_.begin(), deferred_.begin() + static_cast<std::ptrdiff_t>(accepted));
+                                                   if (!deferred_.empty())
+                                                   {
+                                                       wait_for_queue();
+                                                       return;
+                                                   }
+                                                   waiting_writer_ = false;
+                                                   resume(); }); });
+    }
+
+    // Executa reply quando as leituras do sensor ainda nas filas de escrita
+    // tiverem chegado ao LogStore. Sem leituras pendentes (o caso comum)
+    // reply roda imediatamente; senão a sessão fica suspensa até a thread de
+    // escrita avisar, sem bloquear o event loop.
+    void when_written(const SensorLog &log, std::function<void()> reply)
+    {
+        auto self(shared_from_this());
+        if (!writer_.when_written(log, [this, self, reply]
+                                  { boost::asio::post(socket_.get_executor(), [this, self, reply]
+                                                      {
+                                                          waiting_writer_ = false;
+                                                          reply();
+                                                          resume(); }); }))
+        {
+            reply();
+            return;
+        }
+        waiting_writer_ = true;
+    }
+
+    // Com respostas demais aguardando envio a leitura é suspensa até a fila
+    // esvaziar: um cliente que não lê suas respostas só atrasa a si mesmo.
+    void continue_reading()
+    {
+        if (suspended())
+        {
+            reading_paused_ = true;
+            return;
+        }
+        read_some();
+    }
+
+    // Enfileira uma resposta; o envio é assíncrono e nunca bloqueia o event loop
+    void send(std::string message)
+    {
+        outbox_bytes_ += message.size();
+        outbox_.push_back(std::move(message));
+        if (!writing_)
+        {
+            write_next();
+        }
+    }
+
+    void write_next()
+    {
+        writing_ = true;
+        auto self(shared_from_this());
+        boost::asio::async_write(socket_, boost::asio::buffer(outbox_.front()),
+                                 [this, self](boost::system::error_code ec, std::size_t)
+                                 {
+                                     if (ec)
+                                     {
+                                         boost::system::error_code ignored;
+                                         socket_.close(ignored);
+                                         return;
+                                     }
+
+                                     outbox_bytes_ -= outbox_.front().size();
+                                     outbox_.pop_front();
+                                     if (!outbox_.empty())
+                                     {
+                                         write_next();
+                                     }
+                                     else
+                                     {
+                                         writing_ = false;
+                                     }
+
+                                     resume();
+                                 });
+    }
+
+    void process_message(std::string_view message)
+    {
+        if (starts_with(message, "LOG|"))
+        {
+            LogMessage log_message;
+            if (!parse_log_message(message, log_message))
+            {
+                reject(stats_.invalid_messages, "ERROR|INVALID_MESSAGE\r\n");
+                return;
+            }
+
+            Reading reading;
+            if (!parse_iso8601(log_message.timestamp, reading.timestamp, options_.time_zone))
+            {
+                reject(stats_.invalid_timestamps, "ERROR|INVALID_TIMESTAMP\r\n");
+                return;
+            }
+            if (!parse_value(log_message.value, reading.value))
+            {
+                reject(stats_.invalid_values, "ERROR|INVALID_VALUE\r\n");
+                return;
+            }
+            enqueue(sensor(log_message.sensor_id), &reading, 1);
+        }
+        else if (starts_with(message, "LOGB|"))
+        {
+            // O lote é validado inteiro antes de ser gravado: uma leitura
+            // inválida descarta o lote todo
+            LogBatchMessage batch_message;
+            int num_records = 0;
+            if (!parse_log_batch_message(message, batch_message) ||
+                !parse_count(batch_message.num_records, num_records))
+            {
+                reject(stats_.invalid_messages, "ERROR|INVALID_MESSAGE\r\n");
+                return;
+            }
+
+            batch_.clear();
+            std::string_view readings = batch_message.readings;
+            for (int i = 0; i < num_records; ++i)
+            {
+                std::string_view timestamp, value;
+                if (!next_batch_reading(readings, timestamp, value))
                 {
-                    num_records = std::stoi(parts[2]);
+                    reject(stats_.invalid_messages, "ERROR|INVALID_MESSAGE\r\n");
+                    return;
                 }
-                catch (const std::invalid_argument &ia)
+                Reading reading;
+                if (!parse_iso8601(timestamp, reading.timestamp, options_.time_zone))
                 {
-                    std::cerr << "Invalid argument for num_records: " << ia.what() << " value: " << parts[2] << std::endl;
-                    std::string error = "ERROR|INVALID_NUM_RECORDS\\r\\n";
-                    boost::asio::write(socket_, boost::asio::buffer(error));
+                    reject(stats_.invalid_timestamps, "ERROR|INVALID_TIMESTAMP\r\n");
                     return;
                 }
-                catch (const std::out_of_range &oor)
+                if (!parse_value(value, reading.value))
                 {
-                    std::cerr << "Out of Range error for num_records: " << oor.what() << " value: " << parts[2] << std::endl;
-                    std::string error = "ERROR|INVALID_NUM_RECORDS\\r\\n";
-                    boost::asio::write(socket_, boost::asio::buffer(error));
+                    reject(stats_.invalid_values, "ERROR|INVALID_VALUE\r\n");
                     return;
                 }
-
-                bool sensor_exists;
+                batch_.push_back(reading);
+            }
+            if (!readings.empty())
+            {
+                reject(stats_.invalid_messages, "ERROR|INVALID_MESSAGE\r\n");
+                return;
+            }
+            if (!batch_.empty())
+            {
+                enqueue(sensor(batch_message.sensor_id), batch_.data(), batch_.size());
+            }
+        }
+        else if (starts_with(message, "GET|"))
+        {
+            GetMessage get_message;
+            if (parse_get_message(message, get_message))
+            {
+                const std::string_view sensor_id = get_message.sensor_id;
+                int num_records = 0;
+                if (!parse_count(get_message.num_records, num_records))
                 {
-                    std::lock_guard<std::mutex> lock(logs_mutex_);
-                    sensor_exists = (logs_.count(sensor_id) > 0);
+                    reject(stats_.invalid_messages, "ERROR|INVALID_NUM_RECORDS\r\n");
+                    return;
                 }
 
-                if (sensor_exists)
+                SensorLog *log = logs_.find(sensor_id);
+                if (log)
                 {
-                    std::ifstream log_file(sensor_id + ".log", std::ios::binary);
-                    if (!log_file.is_open())
-                    {
-                        // Se o arquivo não puder ser aberto, mesmo que o sensor exista no mapa (improvável se o log foi escrito)
-                        std::string error = "ERROR|CANNOT_READ_LOG_FILE\\r\\n";
-                        boost::asio::write(socket_, boost::asio::buffer(error));
-                        return;
-                    }
-
-                    log_file.seekg(0, std::ios::end);
-                    std::streampos file_size = log_file.tellg();
-                    int total_records = file_size / sizeof(LogRecord);
-
-                    num_records = std::min(num_records, total_records);
-                    log_file.seekg(-num_records * sizeof(LogRecord), std::ios::end);
-
-                    std::ostringstream response;
-                    response << num_records;
-
-                    for (int i = 0; i < num_records; ++i)
-                    {
-                        LogRecord record;
-                        log_file.read(reinterpret_cast<char *>(&record), sizeof(record));
-                        response << ";" << time_t_to_string(record.timestamp) << "|" << record.value;
-                    }
-
-                    response << "\r\n";
-                    boost::asio::write(socket_, boost::asio::buffer(response.str()));
+                    // Responde depois dos registros ainda nas filas de escrita
+                    num_records = std::min(num_records, max_get_records);
+                    when_written(*log, [this, log, num_records]
+                                 {
+                                     std::vector<Reading> readings;
+                                     if (!logs_.read_last(*log, static_cast<std::size_t>(num_records), readings))
+                                     {
+                                         send("ERROR|CANNOT_READ_LOG_FILE\r\n");
+                                         return;
+                                     }
+                                     send_readings(readings); });
                 }
                 else
                 {
-                    std::string error = "ERROR|INVALID_SENSOR_ID\r\n";
-                    boost::asio::write(socket_, boost::asio::buffer(error));
+                    send("ERROR|INVALID_SENSOR_ID\r\n");
                 }
             }
         }
-    }
+        else if (starts_with(message, "RANGE|"))
+        {
+            RangeMessage range_message;
+            if (!parse_range_message(message, range_message))
+            {
+                reject(stats_.invalid_messages, "ERROR|INVALID_MESSAGE\r\n");
+                return;
+            }
 
-    std::vector<std::string> split_message(const std::string &message)
-    {
-        std::vector<std::string> parts;
-        std::istringstream stream(message);
-        std::string part;
-        while (std::getline(stream, part, '|'))
+            std::time_t from, to;
+            if (!parse_iso8601(range_message.from, from, options_.time_zone) ||
+                !parse_iso8601(range_message.to, to, options_.time_zone))
+            {
+                reject(stats_.invalid_timestamps, "ERROR|INVALID_TIMESTAMP\r\n");
+                return;
+            }
+
+            SensorLog *log = logs_.find(range_message.sensor_id);
+            if (!log)
+            {
+                send("ERROR|INVALID_SENSOR_ID\r\n");
+                return;
+            }
+            when_written(*log, [this, log, from, to]
+                         {
+                             std::vector<Reading> readings;
+                             if (!logs_.read_range(*log, from, to, readings))
+                             {
+                                 send("ERROR|CANNOT_READ_LOG_FILE\r\n");
+                                 return;
+                             }
+                             send_readings(readings); });
+        }
+        else if (starts_with(message, "AGG|"))
         {
-            parts.push_back(part);
+            AggMessage agg_message;
+            if (!parse_agg_message(message, agg_message))
+            {
+                reject(stats_.invalid_messages, "ERROR|INVALID_MESSAGE\r\n");
+                return;
+            }
+
+            std::time_t from, to;
+            if (!parse_iso8601(agg_message.from, from, options_.time_zone) ||
+                !parse_iso8601(agg_message.to, to, options_.time_zone))
+            {
+                reject(stats_.invalid_timestamps, "ERROR|INVALID_TIMESTAMP\r\n");
+                return;
+            }
+            std::int64_t bucket_seconds = 0;
+            if (!parse_bucket_seconds(agg_message.bucket, bucket_seconds))
+            {
+                reject(stats_.invalid_messages, "ERROR|INVALID_BUCKET\r\n");
+                return;
+            }
+            std::vector<AggFunction> functions;
+            if (!parse_agg_functions(agg_message.functions, functions))
+            {
+                reject(stats_.invalid_messages, "ERROR|INVALID_FUNCTION\r\n");
+                return;
+            }
+
+            SensorLog *log = logs_.find(agg_message.sensor_id);
+            if (!log)
+            {
+                send("ERROR|INVALID_SENSOR_ID\r\n");
+                return;
+            }
+            when_written(*log, [this, log, from, to, bucket_seconds, functions]
+                         {
+                             Aggregator aggregator(bucket_seconds);
+                             if (!logs_.aggregate(*log, from, to, aggregator))
+                             {
+                                 send("ERROR|CANNOT_READ_LOG_FILE\r\n");
+                                 return;
+                             }
+                             send_buckets(aggregator.buckets(), functions); });
+        }
+        else if (starts_with(message, "STATS"))
+        {
+            LogWriter::Stats stats = writer_.stats();
+            LogStore::Stats store_stats = logs_.stats();
+            std::ostringstream response;
+            response << "STATS|queue_depth=" << stats.queue_depth
+                     << ";queue_capacity=" << stats.queue_capacity
+                     << ";enqueued=" << stats.enqueued
+                     << ";written=" << stats.written
+                     << ";queue_full=" << stats.queue_full
+                     << ";enqueue_avg_ns=" << stats.enqueue_avg_ns
+                     << ";enqueue_max_ns=" << stats.enqueue_max_ns
+                     << ";invalid_messages=" << stats_.invalid_messages.load()
+                     << ";invalid_timestamps=" << stats_.invalid_timestamps.load()
+                     << ";invalid_values=" << stats_.invalid_values.load()
+                     << ";cache_hits=" << store_stats.cache_hits
+                     << ";cache_misses=" << store_stats.cache_misses
+                     << ";rollup_queries=" << store_stats.rollup_queries
+                     << ";open_sensors=" << store_stats.open_sensors
+                     << ";sensor_evictions=" << store_stats.sensor_evictions
+                     << ";sensor_reopens=" << store_stats.sensor_reopens
+                     << ";wal_compactions=" << store_stats.wal_compactions
+                     << "\r\n";
+            send(response.str());
         }
-        return parts;
     }
 
-    std::time_t string_to_time_t(const std::string &time_string)
+    // NUMERO_DE_REGISTROS;DATA_HORA|LEITURA;...
+    void send_readings(const std::vector<Reading> &readings)
     {
-        std::tm tm = {};
-        std::istringstream ss(time_string);
-        // Adicionar verificação de falha para get_time
-        if (!(ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S")))
+        // ";" + data + "|" + leitura: ~32 bytes por registro
+        ResponseWriter response(24 + readings.size() * 32);
+        response.append_count(readings.size());
+        for (const Reading &reading : readings)
         {
-            // Lançar uma exceção ou retornar um valor indicando erro
-            // Por simplicidade, vamos logar e retornar um time_t inválido (0 ou -1)
-            // Em um cenário real, um tratamento de erro mais robusto seria necessário.
-            std::cerr << "Error parsing time string: " << time_string << std::endl;
-            return static_cast<std::time_t>(-1); // Ou lançar std::runtime_error
+            response.append(';');
+            response.append_timestamp(reading.timestamp, timestamps_);
+            response.append('|');
+            response.append_value(reading.value);
         }
-        // Verificar se a conversão foi completa e não há caracteres restantes inválidos
-        if (ss.fail() || !ss.eof())
+
+        response.append("\r\n");
+        send(response.take());
+    }
+
+    // NUMERO_DE_INTERVALOS;DATA_HORA|F1|F2...;...
+    void send_buckets(const std::vector<AggBucket> &buckets, const std::vector<AggFunction> &functions)
+    {
+        ResponseWriter response(24 + buckets.size() * (20 + functions.size() * 14));
+        response.append_count(buckets.size());
+        for (const AggBucket &bucket : buckets)
         {
-            // Se houver caracteres restantes ou a conversão falhou de outra forma
-            char c;
-            if (ss.clear(), ss >> c)
-            { // Tenta ler o próximo caractere
-                std::cerr << "Error parsing time string: " << time_string << " - unexpected character: " << c << std::endl;
-            }
-            else
+            response.append(';');
+            response.append_timestamp(static_cast<std::time_t>(bucket.start), timestamps_);
+            for (AggFunction function : functions)
             {
-                std::cerr << "Error parsing time string: " << time_string << " - format error." << std::endl;
+                response.append('|');
+                switch (function)
+                {
+                case AggFunction::min:
+                    response.append_value(bucket.min);
+                    break;
+                case AggFunction::max:
+                    response.append_value(bucket.max);
+                    break;
+                case AggFunction::avg:
+                    response.append_value(bucket.sum / static_cast<double>(bucket.count));
+                    break;
+                case AggFunction::count:
+                    response.append_count(bucket.count);
+                    break;
+                case AggFunction::first:
+                    response.append_value(bucket.first);
+                    break;
+                case AggFunction::last:
+                    response.append_value(bucket.last);
+                    break;
+                }
             }
-            return static_cast<std::time_t>(-1);
         }
-        return std::mktime(&tm);
+
+        response.append("\r\n");
+        send(response.take());
+    }
+
+    // Sensor de uma mensagem LOG ou LOGB. O handle do último sensor da
+    // conexão é guardado: mensagens seguidas do mesmo sensor (o caso comum)
+    // apenas comparam o id, sem hashing nem locks do registro de sensores.
+    SensorLog &sensor(std::string_view sensor_id)
+    {
+        if (!has_cached_sensor_ || sensor_id != cached_sensor_id_)
+        {
+            cached_handle_ = logs_.intern(sensor_id);
+            cached_sensor_id_.assign(sensor_id.data(), sensor_id.size());
+            has_cached_sensor_ = true;
+        }
+        return logs_.at(cached_handle_);
     }
 
-    std::string time_t_to_string(std::time_t time)
+    // Mensagens inválidas são contadas e respondidas com um código de erro,
+    // sem exceções nem escrita em std::cerr por mensagem.
+    void reject(std::atomic<std::uint64_t> &counter, const char *error)
     {
-        std::tm *tm = std::localtime(&time);
-        std::ostringstream ss;
-        ss << std::put_time(tm, "%Y-%m-%dT%H:%M:%S");
-        return ss.str();
+        counter.fetch_add(1, std::memory_order_relaxed);
+        send(error);
     }
 
     tcp::socket socket_;
-    boost::asio::streambuf buffer_;
-    std::unordered_map<std::string, std::ofstream> &logs_;
-    std::mutex &logs_mutex_; // Adicionado mutex
+    ReadBuffer input_{4 * 1024, max_message_bytes};
+    LogStore &logs_;
+    LogWriter &writer_;
+    const ServerOptions &options_;
+    IngestStats &stats_;
+    TimestampFormatter timestamps_; // cache do dia da última data formatada
+    std::vector<Reading> batch_;    // leituras de um LOGB, reaproveitado entre mensagens
+    std::string cached_sensor_id_;  // último sensor de LOG/LOGB e seu handle
+    std::uint32_t cached_handle_ = 0;
+    bool has_cached_sensor_ = false;
+    std::deque<std::string> outbox_; // respostas aguardando envio
+    std::size_t outbox_bytes_ = 0;
+    bool writing_ = false;
+    bool reading_paused_ = false;
+    bool waiting_writer_ = false;       // aguardando when_written ou espaço na fila
+    std::vector<Reading> deferred_;     // leituras que não couberam na fila de escrita
+    SensorLog *deferred_log_ = nullptr;
+    std::size_t input_missing_ = 1;      // bytes que faltam para a próxima mensagem
+    std::size_t read_size_ = min_read_bytes; // espaço livre pedido para a próxima leitura
+    Protocol protocol_ = Protocol::unknown;
+    SensorLog *binary_log_ = nullptr;    // sensor informado na abertura
+    std::uint64_t binary_readings_ = 0;
 };
 
 class Server
 {
 public:
-    Server(boost::asio::io_context &io_context, short port)
-        : acceptor_(io_context, tcp::endpoint(tcp::v4(), port))
+    Server(IoContextPool &pool, const ServerOptions &options)
+        : pool_(pool), options_(options), logs_(options.store), writer_(logs_, options.writer)
     {
-        accept();
+        tcp::endpoint endpoint(tcp::v4(), options.port);
+        const bool reuse_port = options.reuse_port;
+        // Com SO_REUSEPORT cada thread tem seu próprio acceptor e o kernel
+        // distribui as conexões; caso contrário um único acceptor reparte
+        // os sockets entre os io_contexts do pool.
+        std::size_t num_acceptors = reuse_port ? pool_.size() : 1;
+        for (std::size_t i = 0; i < num_acceptors; ++i)
+        {
+            auto acceptor = std::make_unique<tcp::acceptor>(pool_.at(i));
+            acceptor->open(endpoint.protocol());
+            acceptor->set_option(tcp::acceptor::reuse_address(true));
+            if (reuse_port)
+            {
+                acceptor->set_option(reuse_port_option(true));
+            }
+            acceptor->bind(endpoint);
+            acceptor->listen();
+            acceptors_.push_back(std::move(acceptor));
+        }
+
+        for (auto &acceptor : acceptors_)
+        {
+            accept(*acceptor, reuse_port);
+        }
     }
 
 private:
-    void accept()
+    using reuse_port_option = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
+    void accept(tcp::acceptor &acceptor, bool reuse_port)
     {
-        acceptor_.async_accept(
-            [this](boost::system::error_code ec, tcp::socket socket)
+        // Sem SO_REUSEPORT o socket aceito é associado ao próximo io_context do pool
+        boost::asio::io_context &io_context = reuse_port
+                                                  ? static_cast<boost::asio::io_context &>(acceptor.get_executor().context())
+                                                  : pool_.get_io_context();
+        acceptor.async_accept(
+            io_context,
+            [this, &acceptor, reuse_port](boost::system::error_code ec, tcp::socket socket)
             {
                 if (!ec)
                 {
-                    std::make_shared<Session>(std::move(socket), logs_, logs_mutex_)->start(); // Passar o mutex
+                    std::make_shared<Session>(std::move(socket), logs_, writer_, options_, stats_)->start();
                 }
-                accept();
+                accept(acceptor, reuse_port);
             });
     }
 
-    tcp::acceptor acceptor_;
-    std::unordered_map<std::string, std::ofstream> logs_;
-    std::mutex logs_mutex_; // Adicionado mutex
+    IoContextPool &pool_;
+    const ServerOptions options_;
+    std::vector<std::unique_ptr<tcp::acceptor>> acceptors_;
+    LogStore logs_;
+    LogWriter writer_; // destruído antes de logs_, drenando as filas
+    IngestStats stats_;
 };
 
 int main(int argc, char *argv[])
 {
-    if (argc != 2)
+    ServerOptions options;
+    try
+    {
+        options = parse_options(argc, argv);
+    }
+    catch (const std::invalid_argument &ia)
     {
-        std::cerr << "Usage: server <port>\n";
+        std::cerr << ia.what() << "\n";
+        print_usage();
         return 1;
     }
 
-    boost::asio::io_context io_context;
-    Server server(io_context, std::atoi(argv[1]));
-    io_context.run();
+    IoContextPool pool(options.threads);
+    Server server(pool, options);
+
+    // Encerramento limpo: os lotes pendentes são gravados pelo LogStore
+    boost::asio::signal_set signals(pool.at(0), SIGINT, SIGTERM);
+    signals.async_wait([&pool](boost::system::error_code, int)
+                       { pool.stop(); });
+
+    pool.run();
 
     return 0;
-}
\ No newline at end of file
+}
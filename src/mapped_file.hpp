@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <sys/mman.h>
+
+// Mapeamento somente leitura de um arquivo que só cresce. A região mapeada é
+// maior que o arquivo (páginas além do fim só são válidas depois que o
+// arquivo cresce) e só é refeita quando o tamanho ultrapassa a capacidade,
+// então leituras em um arquivo ativo normalmente não fazem syscalls.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    ~MappedFile()
+    {
+        unmap();
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Garante que os primeiros `size` bytes de fd estão mapeados
+    bool ensure(int fd, std::size_t size)
+    {
+        if (size <= capacity_ && data_)
+        {
+            return true;
+        }
+
+        std::size_t capacity = std::max<std::size_t>(capacity_, min_capacity);
+        while (capacity < size)
+        {
+            capacity *= 2;
+        }
+
+        void *data = data_ ? ::mremap(data_, capacity_, capacity, MREMAP_MAYMOVE)
+                           : ::mmap(nullptr, capacity, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            return false;
+        }
+        data_ = static_cast<char *>(data);
+        capacity_ = capacity;
+        return true;
+    }
+
+    void unmap()
+    {
+        if (data_)
+        {
+            ::munmap(data_, capacity_);
+            data_ = nullptr;
+            capacity_ = 0;
+        }
+    }
+
+    const char *data() const
+    {
+        return data_;
+    }
+
+private:
+    static constexpr std::size_t min_capacity = 1 << 20;
+
+    char *data_ = nullptr;
+    std::size_t capacity_ = 0;
+};
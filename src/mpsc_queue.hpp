@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+
+// Fila circular limitada e sem locks (algoritmo de D. Vyukov). Aceita vários
+// produtores; neste projeto cada fila tem um único consumidor.
+template <typename T>
+class MpscQueue
+{
+public:
+    explicit MpscQueue(std::size_t capacity)
+        : capacity_(round_up_pow2(capacity)), mask_(capacity_ - 1), cells_(new Cell[capacity_])
+    {
+        for (std::size_t i = 0; i < capacity_; ++i)
+        {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    // Retorna false se a fila está cheia
+    bool try_push(const T &value)
+    {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells_[pos & mask_];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.value = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Retorna false se a fila está vazia
+    bool try_pop(T &value)
+    {
+        std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = cells_[pos & mask_];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    value = cell.value;
+                    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Aproximado: produtores e consumidor podem estar em andamento
+    std::size_t size() const
+    {
+        std::size_t enqueued = enqueue_pos_.load(std::memory_order_relaxed);
+        std::size_t dequeued = dequeue_pos_.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    // Total de posições já reservadas por produtores desde a criação da fila
+    std::size_t enqueued() const
+    {
+        return enqueue_pos_.load(std::memory_order_acquire);
+    }
+
+    std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    static std::size_t round_up_pow2(std::size_t n)
+    {
+        if (n < 2)
+        {
+            throw std::invalid_argument("MpscQueue capacity must be at least 2");
+        }
+        std::size_t pow2 = 1;
+        while (pow2 < n)
+        {
+            pow2 <<= 1;
+        }
+        return pow2;
+    }
+
+    const std::size_t capacity_;
+    const std::size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<std::size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<std::size_t> dequeue_pos_{0};
+};
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "log_store.hpp"
+#include "log_writer.hpp"
+#include "time_codec.hpp"
+#include "time_zone.hpp"
+
+// Opções de linha de comando do servidor: das <port> [--opcao=valor ...]
+struct ServerOptions
+{
+    unsigned short port = 0;
+    std::size_t threads = 1; // número de io_contexts (uma thread cada)
+    bool reuse_port = false; // um acceptor por thread com SO_REUSEPORT
+    StoreOptions store;
+    WriterOptions writer;
+    TimeZone time_zone = TimeZone::local(); // fuso em que DATA_HORA é lida e escrita
+    std::size_t max_outbound_bytes = 1 << 20; // respostas pendentes que suspendem a leitura da sessão
+};
+
+inline void print_usage()
+{
+    std::cerr << "Usage: server <port> [options]\n"
+              << "  --threads=N     number of event loop threads (0 = one per core, default 1)\n"
+              << "  --reuseport     one SO_REUSEPORT acceptor per thread\n"
+              << "  --batch-bytes=N write a sensor's pending batch once it reaches N bytes (default 4096)\n"
+              << "  --flush-ms=N    write pending batches older than N ms (default 5)\n"
+              << "  --durability=none|flush|fdatasync\n"
+              << "                  none: write only full batches; flush: also on the time window;\n"
+              << "                  fdatasync: flush plus fdatasync per batch (default flush)\n"
+              << "  --storage=files|wal  files: batches go straight to each sensor's files;\n"
+              << "                  wal: readings go to one shared write-ahead log, compacted into the\n"
+              << "                  sensor files in the background (default files)\n"
+              << "  --wal-bytes=N   write-ahead log size that triggers a compaction (default 67108864)\n"
+              << "  --log-format=v1|v2  format of new sensor log files (default v2)\n"
+              << "  --cache-records=N  recent readings kept in memory per sensor for GET (default 1000)\n"
+              << "  --max-open-sensors=N  sensors with open files at a time (0 = unlimited, default 256)\n"
+              << "  --segment-records=N  seal every N records into a compressed block (0 = off, default 0)\n"
+              << "  --rollups       maintain 1-minute, 1-hour and 1-day aggregates per sensor for AGG\n"
+              << "  --writers=N     disk writer threads fed by lock-free queues (0 = write inline, default 1)\n"
+              << "  --queue-capacity=N  records per writer queue (default 65536)\n"
+              << "  --tz=local|utc|+HH:MM|-HH:MM  time zone of timestamps in messages and replies (default local)\n"
+              << "  --max-outbound-bytes=N  pending reply bytes that pause reading a session (default 1048576)\n";
+}
+
+inline std::size_t parse_size_option(const std::string &name, const std::string &value)
+{
+    try
+    {
+        std::size_t pos = 0;
+        unsigned long long parsed = std::stoull(value, &pos);
+        if (pos != value.size())
+        {
+            throw std::invalid_argument(value);
+        }
+        return static_cast<std::size_t>(parsed);
+    }
+    catch (const std::exception &)
+    {
+        throw std::invalid_argument("Invalid value for " + name + ": " + value);
+    }
+}
+
+inline Durability parse_durability(const std::string &value)
+{
+    if (value == "none")
+        return Durability::none;
+    if (value == "flush")
+        return Durability::flush;
+    if (value == "fdatasync")
+        return Durability::fdatasync;
+    throw std::invalid_argument("Invalid value for --durability: " + value);
+}
+
+// local, utc ou deslocamento fixo no formato +HH:MM / -HH:MM
+inline TimeZone parse_time_zone(const std::string &value)
+{
+    if (value == "local")
+        return TimeZone::local();
+    if (value == "utc" || value == "UTC")
+        return TimeZone::fixed(0);
+
+    unsigned hours, minutes;
+    if (value.size() == 6 && (value[0] == '+' || value[0] == '-') && value[3] == ':' &&
+        time_codec_detail::read_digits(value.data() + 1, 2, hours) &&
+        time_codec_detail::read_digits(value.data() + 4, 2, minutes) &&
+        hours <= 14 && minutes < 60)
+    {
+        long offset = static_cast<long>(hours) * 3600 + minutes * 60;
+        return TimeZone::fixed(value[0] == '-' ? -offset : offset);
+    }
+    throw std::invalid_argument("Invalid value for --tz: " + value);
+}
+
+// Lança std::invalid_argument quando algum argumento é inválido
+inline ServerOptions parse_options(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        throw std::invalid_argument("Missing port");
+    }
+
+    ServerOptions options;
+    options.port = static_cast<unsigned short>(std::atoi(argv[1]));
+
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        std::string name = arg;
+        std::string value;
+        std::size_t eq = arg.find('=');
+        if (eq != std::string::npos)
+        {
+            name = arg.substr(0, eq);
+            value = arg.substr(eq + 1);
+        }
+
+        if (name == "--threads")
+        {
+            options.threads = parse_size_option(name, value);
+        }
+        else if (name == "--reuseport")
+        {
+            options.reuse_port = true;
+        }
+        else if (name == "--batch-bytes")
+        {
+            options.store.batch_bytes = parse_size_option(name, value);
+        }
+        else if (name == "--flush-ms")
+        {
+            options.store.flush_window = std::chrono::milliseconds(parse_size_option(name, value));
+        }
+        else if (name == "--durability")
+        {
+            options.store.durability = parse_durability(value);
+        }
+        else if (name == "--storage")
+        {
+            if (value == "files")
+                options.store.storage = StorageEngine::files;
+            else if (value == "wal")
+                options.store.storage = StorageEngine::wal;
+            else
+                throw std::invalid_argument("Invalid value for --storage: " + value);
+        }
+        else if (name == "--wal-bytes")
+        {
+            options.store.wal_bytes = parse_size_option(name, value);
+        }
+        else if (name == "--tz")
+        {
+            options.time_zone = parse_time_zone(value);
+        }
+        else if (name == "--max-outbound-bytes")
+        {
+            options.max_outbound_bytes = parse_size_option(name, value);
+        }
+        else if (name == "--log-format")
+        {
+            if (value == "v1")
+                options.store.format = LogFormat::v1;
+            else if (value == "v2")
+                options.store.format = LogFormat::v2;
+            else
+                throw std::invalid_argument("Invalid value for --log-format: " + value);
+        }
+        else if (name == "--cache-records")
+        {
+            options.store.cache_records = parse_size_option(name, value);
+        }
+        else if (name == "--max-open-sensors")
+        {
+            options.store.max_open_sensors = parse_size_option(name, value);
+        }
+        else if (name == "--rollups")
+        {
+            options.store.rollups = true;
+        }
+        else if (name == "--segment-records")
+        {
+            options.store.segment_records = parse_size_option(name, value);
+        }
+        else if (name == "--writers")
+        {
+            options.writer.threads = parse_size_option(name, value);
+        }
+        else if (name == "--queue-capacity")
+        {
+            options.writer.queue_capacity = parse_size_option(name, value);
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option: " + arg);
+        }
+    }
+
+    if (options.writer.queue_capacity < 2)
+    {
+        throw std::invalid_argument("--queue-capacity must be at least 2");
+    }
+
+    if (options.threads == 0)
+    {
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    return options;
+}
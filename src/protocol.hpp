@@ -0,0 +1,213 @@
+#pragma once
+
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <system_error>
+
+// Tokenização das mensagens do protocolo texto diretamente sobre o buffer de
+// recepção, sem alocações: os campos retornados apontam para a própria linha.
+
+// Remove o terminador "\r\n" (ou apenas "\n") do fim da linha
+inline std::string_view strip_line_ending(std::string_view line)
+{
+    if (!line.empty() && line.back() == '\n')
+    {
+        line.remove_suffix(1);
+    }
+    if (!line.empty() && line.back() == '\r')
+    {
+        line.remove_suffix(1);
+    }
+    return line;
+}
+
+// Divide a linha nos campos separados por '|'. Retorna o número de campos
+// encontrados, que pode exceder max_fields (os excedentes não são gravados).
+inline std::size_t split_fields(std::string_view line, std::string_view *fields, std::size_t max_fields)
+{
+    std::size_t count = 0;
+    std::size_t start = 0;
+    for (;;)
+    {
+        std::size_t end = line.find('|', start);
+        std::string_view field = line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+        if (count < max_fields)
+        {
+            fields[count] = field;
+        }
+        ++count;
+        if (end == std::string_view::npos)
+        {
+            return count;
+        }
+        start = end + 1;
+    }
+}
+
+inline bool starts_with(std::string_view text, std::string_view prefix)
+{
+    return text.substr(0, prefix.size()) == prefix;
+}
+
+// LOG|SENSOR_ID|DATA_HORA|LEITURA
+struct LogMessage
+{
+    std::string_view sensor_id;
+    std::string_view timestamp;
+    std::string_view value;
+};
+
+inline bool parse_log_message(std::string_view line, LogMessage &message)
+{
+    std::string_view fields[4];
+    if (split_fields(line, fields, 4) != 4 || fields[0] != "LOG")
+    {
+        return false;
+    }
+    message.sensor_id = fields[1];
+    message.timestamp = fields[2];
+    message.value = fields[3];
+    return true;
+}
+
+// LOGB|SENSOR_ID|N;DATA_HORA|LEITURA;...;DATA_HORA|LEITURA
+struct LogBatchMessage
+{
+    std::string_view sensor_id;
+    std::string_view num_records;
+    std::string_view readings; // "DATA_HORA|LEITURA;..." (vazio se N = 0)
+};
+
+inline bool parse_log_batch_message(std::string_view line, LogBatchMessage &message)
+{
+    std::size_t separator = line.find(';');
+    std::string_view fields[3];
+    if (split_fields(line.substr(0, separator), fields, 3) != 3 || fields[0] != "LOGB")
+    {
+        return false;
+    }
+    message.sensor_id = fields[1];
+    message.num_records = fields[2];
+    message.readings = separator == std::string_view::npos ? std::string_view() : line.substr(separator + 1);
+    return true;
+}
+
+// Retira de `readings` o próximo par DATA_HORA|LEITURA de um LOGB
+inline bool next_batch_reading(std::string_view &readings, std::string_view &timestamp, std::string_view &value)
+{
+    std::size_t end = readings.find(';');
+    std::string_view fields[2];
+    if (split_fields(readings.substr(0, end), fields, 2) != 2)
+    {
+        return false;
+    }
+    timestamp = fields[0];
+    value = fields[1];
+    readings = end == std::string_view::npos ? std::string_view() : readings.substr(end + 1);
+    return true;
+}
+
+// GET|SENSOR_ID|NUMERO_DE_REGISTROS
+struct GetMessage
+{
+    std::string_view sensor_id;
+    std::string_view num_records;
+};
+
+inline bool parse_get_message(std::string_view line, GetMessage &message)
+{
+    std::string_view fields[3];
+    if (split_fields(line, fields, 3) != 3 || fields[0] != "GET")
+    {
+        return false;
+    }
+    message.sensor_id = fields[1];
+    message.num_records = fields[2];
+    return true;
+}
+
+// RANGE|SENSOR_ID|DE|ATE
+struct RangeMessage
+{
+    std::string_view sensor_id;
+    std::string_view from;
+    std::string_view to;
+};
+
+inline bool parse_range_message(std::string_view line, RangeMessage &message)
+{
+    std::string_view fields[4];
+    if (split_fields(line, fields, 4) != 4 || fields[0] != "RANGE")
+    {
+        return false;
+    }
+    message.sensor_id = fields[1];
+    message.from = fields[2];
+    message.to = fields[3];
+    return true;
+}
+
+// AGG|SENSOR_ID|DE|ATE|INTERVALO|FUNCOES
+struct AggMessage
+{
+    std::string_view sensor_id;
+    std::string_view from;
+    std::string_view to;
+    std::string_view bucket;
+    std::string_view functions;
+};
+
+inline bool parse_agg_message(std::string_view line, AggMessage &message)
+{
+    std::string_view fields[6];
+    if (split_fields(line, fields, 6) != 6 || fields[0] != "AGG")
+    {
+        return false;
+    }
+    message.sensor_id = fields[1];
+    message.from = fields[2];
+    message.to = fields[3];
+    message.bucket = fields[4];
+    message.functions = fields[5];
+    return true;
+}
+
+// Converte a leitura sem exceções nem alocações. O campo inteiro deve ser
+// consumido; sinal '+' e espaços não são aceitos.
+inline bool parse_value(std::string_view text, double &value)
+{
+    if (text.empty())
+    {
+        return false;
+    }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    const char *last = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), last, value);
+    return ec == std::errc() && ptr == last;
+#else
+    // libstdc++ anterior ao GCC 11 não tem std::from_chars para double
+    char buffer[64];
+    if (text.size() >= sizeof(buffer) || text[0] == '+' || text[0] == ' ')
+    {
+        return false;
+    }
+    std::memcpy(buffer, text.data(), text.size());
+    buffer[text.size()] = '\0';
+    char *end = nullptr;
+    errno = 0;
+    value = std::strtod(buffer, &end);
+    return end == buffer + text.size() && errno != ERANGE;
+#endif
+}
+
+// Inteiro não negativo em decimal, sem exceções
+inline bool parse_count(std::string_view text, int &value)
+{
+    const char *last = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), last, value);
+    return ec == std::errc() && ptr == last && value >= 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+// Buffer de recepção de uma sessão: cada leitura do socket preenche o
+// espaço livre no fim e as mensagens completas são consumidas do início,
+// sem cópias. Os bytes ainda não consumidos só são movidos para o início
+// quando falta espaço, e o buffer só cresce (até max_size) para acomodar
+// uma mensagem maior que ele; depois de esvaziado ele volta ao tamanho
+// inicial, para que sessões ociosas não retenham a memória.
+class ReadBuffer
+{
+public:
+    ReadBuffer(std::size_t initial_size, std::size_t max_size)
+        : storage_(initial_size), initial_size_(initial_size), max_size_(max_size) {}
+
+    // Bytes recebidos e ainda não consumidos
+    std::string_view data() const
+    {
+        return std::string_view(storage_.data() + begin_, end_ - begin_);
+    }
+
+    void consume(std::size_t count)
+    {
+        begin_ += count;
+        if (begin_ == end_)
+        {
+            begin_ = end_ = 0;
+        }
+    }
+
+    // Garante ao menos `min_free` bytes livres após os dados. Retorna false
+    // se isso exigir um buffer maior que max_size.
+    bool prepare(std::size_t min_free)
+    {
+        if (end_ == 0 && storage_.size() > initial_size_ && min_free <= initial_size_)
+        {
+            std::vector<char>(initial_size_).swap(storage_);
+        }
+        if (storage_.size() - end_ >= min_free)
+        {
+            return true;
+        }
+        const std::size_t used = end_ - begin_;
+        if (used + min_free > max_size_)
+        {
+            return false;
+        }
+        if (begin_ > 0)
+        {
+            std::memmove(storage_.data(), storage_.data() + begin_, used);
+            begin_ = 0;
+            end_ = used;
+        }
+        if (storage_.size() < used + min_free)
+        {
+            std::size_t size = storage_.size();
+            while (size < used + min_free)
+            {
+                size *= 2;
+            }
+            storage_.resize(size < max_size_ ? size : max_size_);
+        }
+        return true;
+    }
+
+    // Espaço livre para a próxima leitura do socket
+    char *free_space()
+    {
+        return storage_.data() + end_;
+    }
+
+    std::size_t free_size() const
+    {
+        return storage_.size() - end_;
+    }
+
+    // Marca como recebidos `count` bytes escritos em free_space()
+    void commit(std::size_t count)
+    {
+        end_ += count;
+    }
+
+private:
+    std::vector<char> storage_;
+    const std::size_t initial_size_;
+    const std::size_t max_size_;
+    std::size_t begin_ = 0;
+    std::size_t end_ = 0;
+};
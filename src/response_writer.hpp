@@ -0,0 +1,127 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include "time_zone.hpp"
+
+// Serialização das respostas sem iostreams: datas e números são escritos
+// diretamente em um único buffer reservado de antemão.
+
+// Formata timestamps como "YYYY-MM-DDTHH:MM:SS" no fuso informado, sem
+// localtime nem locks: o deslocamento vem do cache do TimeZone, a hora é
+// calculada aritmeticamente e a parte da data é reaproveitada para todos os
+// timestamps do mesmo dia.
+class TimestampFormatter
+{
+public:
+    static constexpr std::size_t size = 19;
+
+    explicit TimestampFormatter(TimeZone zone = TimeZone::local()) : zone_(zone) {}
+
+    // Escreve exatamente `size` caracteres em out
+    void format(std::time_t time, char *out)
+    {
+        std::int64_t days;
+        long seconds;
+        zone_.to_civil(time, days, seconds);
+        if (days != day_)
+        {
+            load_day(days);
+        }
+        for (std::size_t i = 0; i < 11; ++i)
+        {
+            out[i] = date_[i];
+        }
+        write_2(out + 11, seconds / 3600);
+        out[13] = ':';
+        write_2(out + 14, seconds / 60 % 60);
+        out[16] = ':';
+        write_2(out + 17, seconds % 60);
+    }
+
+private:
+    static void write_2(char *out, long value)
+    {
+        out[0] = static_cast<char>('0' + value / 10);
+        out[1] = static_cast<char>('0' + value % 10);
+    }
+
+    void load_day(std::int64_t days)
+    {
+        CivilDate date = civil_from_days(days);
+        long year = static_cast<long>(date.year % 10000);
+        write_2(date_, year / 100);
+        write_2(date_ + 2, year % 100);
+        date_[4] = '-';
+        write_2(date_ + 5, static_cast<long>(date.month));
+        date_[7] = '-';
+        write_2(date_ + 8, static_cast<long>(date.day));
+        date_[10] = 'T';
+        day_ = days;
+    }
+
+    TimeZone zone_;
+    char date_[11] = {};
+    std::int64_t day_ = INT64_MIN; // nenhum dia carregado
+};
+
+// Buffer de saída de uma resposta
+class ResponseWriter
+{
+public:
+    explicit ResponseWriter(std::size_t reserve = 0)
+    {
+        buffer_.reserve(reserve);
+    }
+
+    void append(std::string_view text)
+    {
+        buffer_.append(text.data(), text.size());
+    }
+
+    void append(char c)
+    {
+        buffer_.push_back(c);
+    }
+
+    void append_count(std::uint64_t value)
+    {
+        char digits[20];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer_.append(digits, result.ptr);
+    }
+
+    // Mesmo texto que `std::ostream << value` com a precisão padrão (%g, 6 dígitos)
+    void append_value(double value)
+    {
+        char digits[32];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+        auto result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, 6);
+        buffer_.append(digits, result.ptr);
+#else
+        // libstdc++ anterior ao GCC 11 não tem std::to_chars para double
+        int length = std::snprintf(digits, sizeof(digits), "%g", value);
+        buffer_.append(digits, static_cast<std::size_t>(length));
+#endif
+    }
+
+    void append_timestamp(std::time_t time, TimestampFormatter &formatter)
+    {
+        const std::size_t offset = buffer_.size();
+        buffer_.resize(offset + TimestampFormatter::size);
+        formatter.format(time, &buffer_[offset]);
+    }
+
+    std::string take()
+    {
+        return std::move(buffer_);
+    }
+
+private:
+    std::string buffer_;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Buffer circular de capacidade fixa que guarda os últimos elementos
+// inseridos. A memória cresce sob demanda até a capacidade.
+template <typename T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(std::size_t capacity = 0)
+        : capacity_(capacity) {}
+
+    void push(const T &value)
+    {
+        if (capacity_ == 0)
+        {
+            return;
+        }
+        if (items_.size() < capacity_)
+        {
+            items_.push_back(value);
+            return;
+        }
+        items_[head_] = value;
+        head_ = (head_ + 1) % capacity_;
+    }
+
+    // Acrescenta a `out` os últimos `count` elementos, do mais antigo ao mais recente
+    void copy_last(std::size_t count, std::vector<T> &out) const
+    {
+        count = std::min(count, items_.size());
+        if (count == 0)
+        {
+            return;
+        }
+        // Quando cheio, o elemento mais antigo está em head_
+        std::size_t start = (head_ + items_.size() - count) % items_.size();
+        std::size_t first_part = std::min(count, items_.size() - start);
+        out.insert(out.end(), items_.begin() + start, items_.begin() + start + first_part);
+        out.insert(out.end(), items_.begin(), items_.begin() + (count - first_part));
+    }
+
+    // Remove todos os elementos e libera a memória
+    void clear()
+    {
+        std::vector<T>().swap(items_);
+        head_ = 0;
+    }
+
+    std::size_t size() const
+    {
+        return items_.size();
+    }
+
+    std::size_t capacity() const
+    {
+        return capacity_;
+    }
+
+private:
+    std::size_t capacity_;
+    std::vector<T> items_;
+    std::size_t head_ = 0; // posição do elemento mais antigo quando cheio
+};
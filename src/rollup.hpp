@@ -0,0 +1,302 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <sys/stat.h>
+#include "log_record.hpp"
+#include "mapped_file.hpp"
+
+// Agregados pré-calculados por intervalo fixo de tempo (1 minuto, 1 hora,
+// 1 dia), mantidos durante a gravação: um arquivo por sensor e nível
+// (SENSOR_ID.r60, .r3600, .r86400) com um RollupRecord por intervalo com
+// leituras, em ordem de início. Intervalos alinhados à época UNIX.
+
+constexpr char rollup_file_magic[4] = {'D', 'A', 'S', 'R'};
+constexpr std::int64_t rollup_tiers[] = {60, 3600, 86400};
+constexpr std::size_t rollup_tier_count = sizeof(rollup_tiers) / sizeof(rollup_tiers[0]);
+
+#pragma pack(push, 1)
+struct RollupFileHeader
+{
+    char magic[4];                // "DASR"
+    std::uint32_t bucket_seconds; // duração de cada intervalo
+    std::uint64_t covered;        // leituras do sensor já incluídas nos agregados
+    std::uint64_t reserved[2];
+};
+
+struct RollupRecord
+{
+    std::int64_t start = 0; // timestamp do início do intervalo
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    double sum = 0;
+    std::uint64_t count = 0;
+    double first = 0; // primeira e última leituras na ordem de gravação
+    double last = 0;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(RollupFileHeader) == 32, "RollupFileHeader must be 32 bytes");
+static_assert(sizeof(RollupRecord) == 56, "RollupRecord must be 56 bytes");
+
+inline std::int64_t floor_to_bucket(std::int64_t timestamp, std::int64_t bucket_seconds)
+{
+    std::int64_t q = timestamp / bucket_seconds;
+    if (timestamp % bucket_seconds < 0)
+    {
+        --q;
+    }
+    return q * bucket_seconds;
+}
+
+// Combina `later` (leituras gravadas depois) em `into`
+inline void merge_rollup(RollupRecord &into, const RollupRecord &later)
+{
+    if (into.count == 0)
+    {
+        into.first = later.first;
+    }
+    into.min = std::min(into.min, later.min);
+    into.max = std::max(into.max, later.max);
+    into.sum += later.sum;
+    into.count += later.count;
+    into.last = later.last;
+}
+
+// Um nível de agregação. As leituras são acumuladas em memória (add) e
+// combinadas com o arquivo em persist(), chamada a cada lote gravado no log.
+// O arquivo não usa O_APPEND: registros existentes são atualizados no lugar.
+class RollupFile
+{
+public:
+    RollupFile() = default;
+
+    ~RollupFile()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+        }
+    }
+
+    RollupFile(const RollupFile &) = delete;
+    RollupFile &operator=(const RollupFile &) = delete;
+
+    // Retorna false em caso de erro. `covered` recebe o número de leituras
+    // já incluídas; um arquivo novo ou inválido é recriado vazio.
+    bool open(const std::string &path, std::int64_t bucket_seconds, std::uint64_t &covered)
+    {
+        bucket_ = bucket_seconds;
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+        {
+            std::cerr << "Error: Could not open rollup file " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        struct stat st;
+        std::size_t file_size = ::fstat(fd_, &st) == 0 ? static_cast<std::size_t>(st.st_size) : 0;
+        RollupFileHeader header;
+        if (file_size >= sizeof(header) &&
+            ::pread(fd_, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+            std::memcmp(header.magic, rollup_file_magic, sizeof(header.magic)) == 0 &&
+            header.bucket_seconds == bucket_)
+        {
+            records_ = (file_size - sizeof(header)) / sizeof(RollupRecord);
+            covered = header.covered;
+            return true;
+        }
+        covered = 0;
+        return reset();
+    }
+
+    // Fecha o arquivo; agregados ainda não persistidos são descartados
+    void close()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        records_ = 0;
+        std::vector<RollupRecord>().swap(pending_);
+        mapping_.unmap();
+    }
+
+    // Descarta todos os agregados
+    bool reset()
+    {
+        records_ = 0;
+        pending_.clear();
+        return ::ftruncate(fd_, 0) == 0 && write_header(0);
+    }
+
+    void add(const Reading &reading)
+    {
+        const std::int64_t start = floor_to_bucket(reading.timestamp, bucket_);
+        RollupRecord *record = nullptr;
+        for (auto it = pending_.rbegin(); it != pending_.rend(); ++it)
+        {
+            if (it->start == start)
+            {
+                record = &*it;
+                break;
+            }
+        }
+        if (!record)
+        {
+            pending_.emplace_back();
+            record = &pending_.back();
+            record->start = start;
+        }
+
+        RollupRecord single;
+        single.start = start;
+        single.min = single.max = single.sum = single.first = single.last = reading.value;
+        single.count = 1;
+        merge_rollup(*record, single);
+    }
+
+    // Combina as leituras acumuladas com o arquivo e registra `covered`
+    void persist(std::uint64_t covered)
+    {
+        if (fd_ < 0)
+        {
+            return;
+        }
+        for (const RollupRecord &delta : pending_)
+        {
+            upsert(delta);
+        }
+        pending_.clear();
+        write_header(covered);
+    }
+
+    // Chama visit(record) para os intervalos inteiramente contidos em
+    // [from, to], em ordem
+    template <typename Visitor>
+    bool scan(std::int64_t from, std::int64_t to, Visitor &&visit)
+    {
+        if (records_ == 0)
+        {
+            return true;
+        }
+        if (!map())
+        {
+            return false;
+        }
+        std::size_t i = lower_bound(from);
+        for (; i < records_; ++i)
+        {
+            RollupRecord record = at(i);
+            if (record.start + bucket_ - 1 > to)
+            {
+                break;
+            }
+            visit(record);
+        }
+        return true;
+    }
+
+    std::int64_t bucket_seconds() const
+    {
+        return bucket_;
+    }
+
+private:
+    bool write_header(std::uint64_t covered)
+    {
+        RollupFileHeader header{};
+        std::memcpy(header.magic, rollup_file_magic, sizeof(header.magic));
+        header.bucket_seconds = static_cast<std::uint32_t>(bucket_);
+        header.covered = covered;
+        return ::pwrite(fd_, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    }
+
+    bool map()
+    {
+        if (!mapping_.ensure(fd_, sizeof(RollupFileHeader) + records_ * sizeof(RollupRecord)))
+        {
+            std::cerr << "Error: Could not map rollup file: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    RollupRecord at(std::size_t i) const
+    {
+        RollupRecord record;
+        std::memcpy(&record, mapping_.data() + sizeof(RollupFileHeader) + i * sizeof(record), sizeof(record));
+        return record;
+    }
+
+    // Primeiro registro com início >= start
+    std::size_t lower_bound(std::int64_t start) const
+    {
+        std::size_t low = 0;
+        std::size_t high = records_;
+        while (low < high)
+        {
+            std::size_t mid = low + (high - low) / 2;
+            if (at(mid).start < start)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        return low;
+    }
+
+    void write_record(std::size_t i, const RollupRecord &record)
+    {
+        ::pwrite(fd_, &record, sizeof(record), static_cast<off_t>(sizeof(RollupFileHeader) + i * sizeof(record)));
+    }
+
+    // O caso comum (leituras em ordem) atualiza o último registro ou
+    // acrescenta um novo; um intervalo novo no meio do arquivo desloca os
+    // registros seguintes.
+    void upsert(const RollupRecord &delta)
+    {
+        if (records_ > 0 && !map())
+        {
+            return;
+        }
+        std::size_t i = records_ > 0 && at(records_ - 1).start <= delta.start ? records_ - 1 : lower_bound(delta.start);
+        if (i < records_ && at(i).start == delta.start)
+        {
+            RollupRecord record = at(i);
+            merge_rollup(record, delta);
+            write_record(i, record);
+            return;
+        }
+        if (i < records_ && at(i).start < delta.start)
+        {
+            ++i; // depois do último registro
+        }
+
+        std::vector<RollupRecord> tail;
+        for (std::size_t j = i; j < records_; ++j)
+        {
+            tail.push_back(at(j));
+        }
+        write_record(i, delta);
+        for (std::size_t j = 0; j < tail.size(); ++j)
+        {
+            write_record(i + 1 + j, tail[j]);
+        }
+        ++records_;
+    }
+
+    int fd_ = -1;
+    std::int64_t bucket_ = 60;
+    std::size_t records_ = 0;
+    std::vector<RollupRecord> pending_; // leituras ainda não combinadas com o arquivo
+    MappedFile mapping_;
+};
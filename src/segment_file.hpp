@@ -0,0 +1,327 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <sys/stat.h>
+#include "gorilla.hpp"
+#include "log_record.hpp"
+#include "mapped_file.hpp"
+
+// Arquivo de segmentos comprimidos de um sensor (SENSOR_ID.gts): um
+// cabeçalho seguido de blocos selados, cada um com milhares de leituras
+// codificadas com gorilla_encode. Os blocos só são acrescentados, na ordem
+// de chegada das leituras.
+
+constexpr char segment_file_magic[4] = {'D', 'A', 'S', 'G'};
+
+#pragma pack(push, 1)
+struct SegmentFileHeader
+{
+    char magic[4];             // "DASG"
+    std::uint16_t version;     // 1
+    std::uint16_t reserved;
+    std::uint32_t header_size; // sizeof(SegmentFileHeader); o primeiro bloco começa aqui
+    std::uint32_t reserved2;
+};
+
+struct SegmentBlockHeader
+{
+    std::uint32_t payload_bytes; // bytes codificados após este cabeçalho
+    std::uint32_t count;         // leituras no bloco
+    std::int64_t min_timestamp;  // em ordem de tempo, o da primeira leitura
+    std::int64_t max_timestamp;  // em ordem de tempo, o da última leitura
+};
+#pragma pack(pop)
+
+static_assert(sizeof(SegmentFileHeader) == 16, "SegmentFileHeader must be 16 bytes");
+static_assert(sizeof(SegmentBlockHeader) == 24, "SegmentBlockHeader must be 24 bytes");
+
+class SegmentFile
+{
+public:
+    struct Block
+    {
+        std::size_t offset; // início do payload no arquivo
+        SegmentBlockHeader header;
+    };
+
+    SegmentFile() = default;
+
+    ~SegmentFile()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+        }
+    }
+
+    SegmentFile(const SegmentFile &) = delete;
+    SegmentFile &operator=(const SegmentFile &) = delete;
+
+    // Abre o arquivo e carrega o índice de blocos. Sem `create`, um arquivo
+    // inexistente não é erro: o sensor simplesmente não tem segmentos. Um
+    // bloco incompleto no fim (escrita interrompida) é descartado.
+    bool open(const std::string &path, bool create)
+    {
+        fd_ = ::open(path.c_str(), O_RDWR | O_APPEND | O_CLOEXEC | (create ? O_CREAT : 0), 0644);
+        if (fd_ < 0)
+        {
+            if (!create && errno == ENOENT)
+            {
+                return true;
+            }
+            std::cerr << "Error: Could not open segment file " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        struct stat st;
+        file_size_ = ::fstat(fd_, &st) == 0 ? static_cast<std::size_t>(st.st_size) : 0;
+        if (file_size_ == 0)
+        {
+            SegmentFileHeader header{};
+            std::memcpy(header.magic, segment_file_magic, sizeof(header.magic));
+            header.version = 1;
+            header.header_size = sizeof(header);
+            return write_all(reinterpret_cast<const char *>(&header), sizeof(header));
+        }
+
+        SegmentFileHeader header;
+        if (::pread(fd_, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+            std::memcmp(header.magic, segment_file_magic, sizeof(header.magic)) != 0 || header.version != 1 ||
+            header.header_size < sizeof(header))
+        {
+            std::cerr << "Error: Unrecognized segment file header in " << path << std::endl;
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+
+        std::size_t offset = header.header_size;
+        SegmentBlockHeader block;
+        while (offset + sizeof(block) <= file_size_ &&
+               ::pread(fd_, &block, sizeof(block), static_cast<off_t>(offset)) == static_cast<ssize_t>(sizeof(block)) &&
+               offset + sizeof(block) + block.payload_bytes <= file_size_)
+        {
+            add_block(Block{offset + sizeof(block), block});
+            offset += sizeof(block) + block.payload_bytes;
+        }
+        if (offset < file_size_)
+        {
+            std::cerr << "Warning: Discarding incomplete block at the end of " << path << std::endl;
+            if (::ftruncate(fd_, static_cast<off_t>(offset)) == 0)
+            {
+                file_size_ = offset;
+            }
+        }
+        return true;
+    }
+
+    bool is_open() const
+    {
+        return fd_ >= 0;
+    }
+
+    // Fecha o arquivo e libera o índice de blocos e o mapeamento; open()
+    // pode ser chamada de novo
+    void close()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        file_size_ = 0;
+        records_ = 0;
+        ordered_ = true;
+        std::vector<Block>().swap(blocks_);
+        std::vector<std::uint8_t>().swap(buffer_);
+        std::vector<Reading>().swap(scratch_);
+        mapping_.unmap();
+    }
+
+    // Codifica e grava um bloco selado com as leituras dadas
+    bool append(const Reading *readings, std::size_t count, bool sync)
+    {
+        if (count == 0)
+        {
+            return true;
+        }
+
+        buffer_.assign(sizeof(SegmentBlockHeader), 0);
+        gorilla_encode(readings, count, buffer_);
+
+        SegmentBlockHeader header;
+        header.payload_bytes = static_cast<std::uint32_t>(buffer_.size() - sizeof(header));
+        header.count = static_cast<std::uint32_t>(count);
+        header.min_timestamp = header.max_timestamp = readings[0].timestamp;
+        for (std::size_t i = 1; i < count; ++i)
+        {
+            header.min_timestamp = std::min<std::int64_t>(header.min_timestamp, readings[i].timestamp);
+            header.max_timestamp = std::max<std::int64_t>(header.max_timestamp, readings[i].timestamp);
+        }
+        std::memcpy(buffer_.data(), &header, sizeof(header));
+
+        const std::size_t offset = file_size_ + sizeof(header);
+        if (!write_all(reinterpret_cast<const char *>(buffer_.data()), buffer_.size()))
+        {
+            return false;
+        }
+        if (sync)
+        {
+            ::fdatasync(fd_);
+        }
+        add_block(Block{offset, header});
+        return true;
+    }
+
+    // Acrescenta a `out` as últimas `count` leituras dos blocos (ou todas,
+    // se houver menos), decodificando apenas os blocos necessários
+    bool read_last(std::size_t count, std::vector<Reading> &out)
+    {
+        count = std::min(count, records_);
+        if (count == 0)
+        {
+            return true;
+        }
+        if (!mapping_.ensure(fd_, file_size_))
+        {
+            std::cerr << "Error: Could not map segment file: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        std::size_t first = blocks_.size();
+        std::size_t covered = 0;
+        while (covered < count)
+        {
+            covered += blocks_[--first].header.count;
+        }
+
+        const std::size_t base = out.size();
+        for (std::size_t i = first; i < blocks_.size(); ++i)
+        {
+            const Block &block = blocks_[i];
+            gorilla_decode(reinterpret_cast<const std::uint8_t *>(mapping_.data()) + block.offset,
+                           block.header.payload_bytes, block.header.count, out);
+        }
+        out.erase(out.begin() + static_cast<std::ptrdiff_t>(base),
+                  out.begin() + static_cast<std::ptrdiff_t>(base + covered - count));
+        return true;
+    }
+
+    // Chama visit(readings, count) com as leituras de cada bloco cujo
+    // timestamp está em [from, to]. Só os blocos que cruzam o intervalo são
+    // decodificados. Com os blocos em ordem de tempo (o caso comum) o
+    // primeiro é achado por busca binária e a varredura para no primeiro
+    // bloco posterior a `to`; senão todos os cabeçalhos são examinados.
+    template <typename Visitor>
+    bool scan_range(std::int64_t from, std::int64_t to, Visitor &&visit)
+    {
+        auto it = blocks_.begin();
+        if (ordered_)
+        {
+            it = std::partition_point(blocks_.begin(), blocks_.end(), [from](const Block &block)
+                                      { return block.header.max_timestamp < from; });
+        }
+        if (it == blocks_.end() || (ordered_ && it->header.min_timestamp > to))
+        {
+            return true;
+        }
+        if (!mapping_.ensure(fd_, file_size_))
+        {
+            std::cerr << "Error: Could not map segment file: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        for (; it != blocks_.end(); ++it)
+        {
+            if (it->header.min_timestamp > to || it->header.max_timestamp < from)
+            {
+                if (ordered_)
+                {
+                    break;
+                }
+                continue;
+            }
+            scratch_.clear();
+            gorilla_decode(reinterpret_cast<const std::uint8_t *>(mapping_.data()) + it->offset,
+                           it->header.payload_bytes, it->header.count, scratch_);
+            auto last = std::remove_if(scratch_.begin(), scratch_.end(), [from, to](const Reading &reading)
+                                       { return reading.timestamp < from || reading.timestamp > to; });
+            if (last != scratch_.begin())
+            {
+                visit(scratch_.data(), static_cast<std::size_t>(last - scratch_.begin()));
+            }
+        }
+        return true;
+    }
+
+    const std::vector<Block> &blocks() const
+    {
+        return blocks_;
+    }
+
+    // Se os intervalos de tempo dos blocos não se sobrepõem e seguem a
+    // ordem dos blocos
+    bool ordered() const
+    {
+        return ordered_;
+    }
+
+    std::size_t records() const
+    {
+        return records_;
+    }
+
+    std::size_t file_size() const
+    {
+        return file_size_;
+    }
+
+private:
+    void add_block(const Block &block)
+    {
+        if (!blocks_.empty() && block.header.min_timestamp < blocks_.back().header.max_timestamp)
+        {
+            ordered_ = false;
+        }
+        blocks_.push_back(block);
+        records_ += block.header.count;
+    }
+
+    bool write_all(const char *data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t written = ::write(fd_, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                std::cerr << "Error: Could not write segment file: " << std::strerror(errno) << std::endl;
+                return false;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+            file_size_ += static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+    int fd_ = -1;
+    std::size_t file_size_ = 0;
+    std::size_t records_ = 0;
+    std::vector<Block> blocks_;
+    bool ordered_ = true;
+    std::vector<std::uint8_t> buffer_;
+    std::vector<Reading> scratch_;
+    MappedFile mapping_;
+};
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+#include <sys/stat.h>
+
+// Catálogo persistente dos sensores conhecidos (sensors.cat): permite que
+// GET, RANGE e AGG reconheçam sensores de execuções anteriores sem varrer os
+// arquivos de log. Cada sensor recebe um número (handle) na ordem em que foi
+// visto e ocupa uma entrada de tamanho fixo, atualizada no lugar.
+//
+// As estatísticas de cada entrada (primeiro e último timestamp, número de
+// leituras) são atualizadas a cada lote gravado, sem fdatasync: após uma
+// interrupção podem estar defasadas e são corrigidas quando o sensor abre
+// seu log.
+
+constexpr char sensor_catalog_magic[4] = {'D', 'A', 'S', 'C'};
+
+#pragma pack(push, 1)
+struct SensorCatalogHeader
+{
+    char magic[4];            // "DASC"
+    std::uint16_t version;    // 1
+    std::uint16_t entry_size; // sizeof(SensorCatalogEntry)
+    std::uint64_t reserved;
+};
+
+struct SensorSummary
+{
+    std::int64_t first_timestamp = std::numeric_limits<std::int64_t>::max(); // sem leituras: first > last
+    std::int64_t last_timestamp = std::numeric_limits<std::int64_t>::min();
+    std::uint64_t records = 0;
+};
+
+struct SensorCatalogEntry
+{
+    std::uint32_t handle;
+    std::uint8_t id_size;
+    char reserved[3];
+    SensorSummary summary;
+    char sensor_id[96];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(SensorCatalogHeader) == 16, "SensorCatalogHeader must be 16 bytes");
+static_assert(sizeof(SensorCatalogEntry) == 128, "SensorCatalogEntry must be 128 bytes");
+
+class SensorCatalog
+{
+public:
+    static constexpr std::uint32_t no_handle = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::size_t max_id_size = sizeof(SensorCatalogEntry::sensor_id);
+
+    struct Sensor
+    {
+        std::string sensor_id;
+        std::uint32_t handle;
+        SensorSummary summary;
+    };
+
+    SensorCatalog() = default;
+
+    ~SensorCatalog()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+        }
+    }
+
+    SensorCatalog(const SensorCatalog &) = delete;
+    SensorCatalog &operator=(const SensorCatalog &) = delete;
+
+    // Carrega o catálogo com uma única leitura. Se ele não existe, é criado
+    // com os sensores dos arquivos *.log do diretório (migração de dados
+    // anteriores ao catálogo); suas estatísticas são preenchidas quando
+    // cada sensor abre o log.
+    bool open(const std::string &path)
+    {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+        {
+            std::cerr << "Error: Could not open sensor catalog " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        struct stat st;
+        const std::size_t file_size = ::fstat(fd_, &st) == 0 ? static_cast<std::size_t>(st.st_size) : 0;
+        if (file_size == 0)
+        {
+            SensorCatalogHeader header{};
+            std::memcpy(header.magic, sensor_catalog_magic, sizeof(header.magic));
+            header.version = 1;
+            header.entry_size = sizeof(SensorCatalogEntry);
+            if (::pwrite(fd_, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)))
+            {
+                return fail(path);
+            }
+            import_logs(std::filesystem::path(path).parent_path());
+            return true;
+        }
+
+        std::vector<char> data(file_size);
+        SensorCatalogHeader header;
+        if (::pread(fd_, data.data(), file_size, 0) != static_cast<ssize_t>(file_size) || file_size < sizeof(header))
+        {
+            return fail(path);
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+        if (std::memcmp(header.magic, sensor_catalog_magic, sizeof(header.magic)) != 0 || header.version != 1 ||
+            header.entry_size != sizeof(SensorCatalogEntry))
+        {
+            std::cerr << "Error: Unrecognized sensor catalog header in " << path << std::endl;
+            return fail(path);
+        }
+
+        // Uma entrada incompleta no fim (escrita interrompida) é descartada
+        const std::size_t count = (file_size - sizeof(header)) / sizeof(SensorCatalogEntry);
+        sensors_.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            SensorCatalogEntry entry;
+            std::memcpy(&entry, data.data() + sizeof(header) + i * sizeof(entry), sizeof(entry));
+            if (entry.handle != i || entry.id_size == 0 || entry.id_size > max_id_size)
+            {
+                std::cerr << "Warning: Discarding sensor catalog from entry " << i << " in " << path << std::endl;
+                break;
+            }
+            sensors_.push_back(Sensor{std::string(entry.sensor_id, entry.id_size), entry.handle, entry.summary});
+        }
+        next_handle_ = static_cast<std::uint32_t>(sensors_.size());
+        ::ftruncate(fd_, static_cast<off_t>(sizeof(header) + sensors_.size() * sizeof(SensorCatalogEntry)));
+        return true;
+    }
+
+    // Sensores carregados em open(), na ordem dos handles
+    const std::vector<Sensor> &sensors() const
+    {
+        return sensors_;
+    }
+
+    // Libera a lista carregada em open(), depois de usada
+    void release_sensors()
+    {
+        std::vector<Sensor>().swap(sensors_);
+    }
+
+    // Registra um sensor novo. Retorna no_handle se o catálogo não está
+    // aberto ou o id não cabe em uma entrada (o sensor funciona normalmente,
+    // mas não é lembrado após reiniciar).
+    std::uint32_t add(std::string_view sensor_id)
+    {
+        if (fd_ < 0 || sensor_id.empty() || sensor_id.size() > max_id_size)
+        {
+            return no_handle;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        SensorCatalogEntry entry{};
+        entry.handle = next_handle_;
+        entry.id_size = static_cast<std::uint8_t>(sensor_id.size());
+        std::memcpy(entry.sensor_id, sensor_id.data(), sensor_id.size());
+        if (::pwrite(fd_, &entry, sizeof(entry), entry_offset(entry.handle)) != static_cast<ssize_t>(sizeof(entry)))
+        {
+            std::cerr << "Error: Could not write sensor catalog: " << std::strerror(errno) << std::endl;
+            return no_handle;
+        }
+        return next_handle_++;
+    }
+
+    // Grava as estatísticas de um sensor. Sensores diferentes podem ser
+    // atualizados em paralelo: cada um escreve apenas a sua entrada.
+    void update(std::uint32_t handle, const SensorSummary &summary)
+    {
+        if (fd_ < 0 || handle == no_handle)
+        {
+            return;
+        }
+        char bytes[sizeof(SensorSummary)];
+        std::memcpy(bytes, &summary, sizeof(bytes));
+        ::pwrite(fd_, bytes, sizeof(bytes), entry_offset(handle) + offsetof(SensorCatalogEntry, summary));
+    }
+
+private:
+    static off_t entry_offset(std::uint32_t handle)
+    {
+        return static_cast<off_t>(sizeof(SensorCatalogHeader) + static_cast<std::size_t>(handle) * sizeof(SensorCatalogEntry));
+    }
+
+    bool fail(const std::string &path)
+    {
+        std::cerr << "Error: Could not read sensor catalog " << path << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    void import_logs(const std::filesystem::path &directory)
+    {
+        std::error_code ec;
+        for (const auto &file : std::filesystem::directory_iterator(directory.empty() ? "." : directory, ec))
+        {
+            const std::filesystem::path &path = file.path();
+            if (path.extension() != ".log" || !file.is_regular_file(ec))
+            {
+                continue;
+            }
+            const std::string sensor_id = path.stem().string();
+            const std::uint32_t handle = add(sensor_id);
+            if (handle != no_handle)
+            {
+                sensors_.push_back(Sensor{sensor_id, handle, SensorSummary()});
+            }
+        }
+        if (!sensors_.empty())
+        {
+            std::cerr << "Imported " << sensors_.size() << " sensors into the sensor catalog" << std::endl;
+        }
+    }
+
+    int fd_ = -1;
+    std::mutex mutex_;
+    std::uint32_t next_handle_ = 0;
+    std::vector<Sensor> sensors_;
+};
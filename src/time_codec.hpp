@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string_view>
+
+// Conversão de datas ISO-8601 de formato fixo sem iostreams, locale ou mktime.
+
+// Dias desde 1970-01-01 para uma data do calendário gregoriano proléptico
+// (algoritmo days_from_civil de H. Hinnant). Dias fora do mês são
+// normalizados linearmente, como faz std::mktime.
+constexpr std::int64_t days_from_civil(std::int64_t y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+// Inverso de days_from_civil
+struct CivilDate
+{
+    std::int64_t year;
+    unsigned month;
+    unsigned day;
+};
+
+constexpr CivilDate civil_from_days(std::int64_t days)
+{
+    days += 719468;
+    const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    return CivilDate{static_cast<std::int64_t>(yoe) + era * 400 + (m <= 2), m, d};
+}
+
+namespace time_codec_detail
+{
+    // Lê `count` dígitos a partir de p; retorna false se algum não for dígito
+    inline bool read_digits(const char *p, int count, unsigned &value)
+    {
+        unsigned result = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            unsigned digit = static_cast<unsigned char>(p[i]) - '0';
+            if (digit > 9)
+            {
+                return false;
+            }
+            result = result * 10 + digit;
+        }
+        value = result;
+        return true;
+    }
+}
+
+// Faixa de timestamps que parse_iso8601 pode produzir: anos 0000 a 9999,
+// com um dia de folga para o deslocamento do fuso. Deltas, alinhamento de
+// agregados e formatação de datas não transbordam dentro dela.
+constexpr std::int64_t earliest_timestamp = (days_from_civil(0, 1, 1) - 1) * 86400;
+constexpr std::int64_t latest_timestamp = (days_from_civil(10000, 1, 1) + 1) * 86400;
+
+inline bool timestamp_in_range(std::time_t timestamp)
+{
+    const std::int64_t value = static_cast<std::int64_t>(timestamp);
+    return value >= earliest_timestamp && value <= latest_timestamp;
+}
+
+// Converte "YYYY-MM-DDTHH:MM:SS" com fração de segundos opcional (".ffffff",
+// como produzido por datetime.isoformat()) para segundos desde a época.
+// A data é interpretada no fuso de deslocamento fixo utc_offset (segundos a
+// leste de UTC); a fração é descartada. Retorna false se o formato é inválido.
+inline bool parse_iso8601(std::string_view text, std::time_t &result, long utc_offset = 0)
+{
+    using time_codec_detail::read_digits;
+
+    if (text.size() < 19)
+    {
+        return false;
+    }
+
+    const char *p = text.data();
+    unsigned year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    bool ok = read_digits(p, 4, year) & (p[4] == '-') &
+              read_digits(p + 5, 2, month) & (p[7] == '-') &
+              read_digits(p + 8, 2, day) & (p[10] == 'T') &
+              read_digits(p + 11, 2, hour) & (p[13] == ':') &
+              read_digits(p + 14, 2, minute) & (p[16] == ':') &
+              read_digits(p + 17, 2, second);
+    ok &= (month - 1 < 12) & (day - 1 < 31) & (hour < 24) & (minute < 60) & (second <= 60);
+    if (!ok)
+    {
+        return false;
+    }
+
+    if (text.size() > 19)
+    {
+        // Fração opcional: '.' seguido de ao menos um dígito
+        if (text[19] != '.' || text.size() == 20)
+        {
+            return false;
+        }
+        for (std::size_t i = 20; i < text.size(); ++i)
+        {
+            if (static_cast<unsigned>(text[i] - '0') > 9)
+            {
+                return false;
+            }
+        }
+    }
+
+    std::int64_t days = days_from_civil(year, month, day);
+    result = static_cast<std::time_t>(days * 86400 + hour * 3600 + minute * 60 + second - utc_offset);
+    return true;
+}
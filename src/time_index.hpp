@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <sys/stat.h>
+
+// Índice esparso de timestamps de um arquivo de log (SENSOR_ID.idx): para
+// cada bloco de `interval` registros, uma entrada com o maior timestamp até
+// o registro i * interval. As entradas nunca diminuem, então a busca
+// binária vale mesmo com leituras fora de ordem; o cabeçalho registra se
+// alguma leitura chegou fora de ordem, caso em que uma consulta não pode
+// parar no primeiro timestamp posterior ao intervalo.
+//
+// O índice pode ser reconstruído a partir do log, então nunca recebe fsync;
+// ao abrir, entradas que faltam são recalculadas e entradas a mais (log
+// truncado) são descartadas.
+
+constexpr char time_index_magic[4] = {'D', 'A', 'S', 'I'};
+
+#pragma pack(push, 1)
+struct TimeIndexHeader
+{
+    char magic[4];          // "DASI"
+    std::uint32_t interval; // registros por entrada
+    std::uint32_t version;  // 1
+    std::uint32_t flags;    // time_index_unordered
+};
+#pragma pack(pop)
+
+static_assert(sizeof(TimeIndexHeader) == 16, "TimeIndexHeader must be 16 bytes");
+
+constexpr std::uint32_t time_index_version = 1;
+constexpr std::uint32_t time_index_unordered = 1; // alguma leitura anterior à maior já gravada
+
+class TimeIndex
+{
+public:
+    TimeIndex() = default;
+
+    ~TimeIndex()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+        }
+    }
+
+    TimeIndex(const TimeIndex &) = delete;
+    TimeIndex &operator=(const TimeIndex &) = delete;
+
+    // Abre o índice de um log com `records` registros; timestamp_at(i)
+    // retorna o timestamp do i-ésimo registro do log. Um índice com outro
+    // intervalo ou cabeçalho inválido é recriado. Os registros a partir da
+    // última entrada são relidos para recuperar o maior timestamp.
+    template <typename TimestampAt>
+    bool open(const std::string &path, std::size_t interval, std::size_t records, TimestampAt timestamp_at)
+    {
+        interval_ = std::max<std::size_t>(interval, 1);
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+        {
+            std::cerr << "Error: Could not open index file " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        struct stat st;
+        std::size_t file_size = ::fstat(fd_, &st) == 0 ? static_cast<std::size_t>(st.st_size) : 0;
+        TimeIndexHeader header;
+        bool valid = file_size >= sizeof(header) &&
+                     ::pread(fd_, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+                     std::memcmp(header.magic, time_index_magic, sizeof(header.magic)) == 0 &&
+                     header.interval == interval_ && header.version == time_index_version;
+
+        const std::size_t expected = (records + interval_ - 1) / interval_;
+        if (valid)
+        {
+            entries_.resize(std::min(expected, (file_size - sizeof(header)) / sizeof(std::int64_t)));
+            if (!entries_.empty() &&
+                ::pread(fd_, entries_.data(), entries_.size() * sizeof(std::int64_t), sizeof(header)) !=
+                    static_cast<ssize_t>(entries_.size() * sizeof(std::int64_t)))
+            {
+                entries_.clear();
+            }
+        }
+        ordered_ = !valid || !(header.flags & time_index_unordered);
+        if (!valid)
+        {
+            write_header();
+        }
+
+        written_ = entries_.size();
+        max_timestamp_ = entries_.empty() ? std::numeric_limits<std::int64_t>::min() : entries_.back();
+        for (std::size_t i = entries_.empty() ? 0 : (entries_.size() - 1) * interval_; i < records; ++i)
+        {
+            add(i, timestamp_at(i));
+        }
+        ::ftruncate(fd_, static_cast<off_t>(sizeof(header) + written_ * sizeof(std::int64_t)));
+        flush();
+        return true;
+    }
+
+    bool is_open() const
+    {
+        return fd_ >= 0;
+    }
+
+    // Se todas as leituras do log chegaram em ordem de tempo. Sem o arquivo
+    // nada se sabe sobre a ordem.
+    bool ordered() const
+    {
+        return fd_ >= 0 && ordered_;
+    }
+
+    // Grava as entradas pendentes e fecha o arquivo; open() pode ser
+    // chamada de novo
+    void close()
+    {
+        flush();
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        std::vector<std::int64_t>().swap(entries_);
+        written_ = 0;
+        ordered_ = true;
+        max_timestamp_ = std::numeric_limits<std::int64_t>::min();
+    }
+
+    // Informa o timestamp do registro `record` acrescentado ao log. A
+    // primeira leitura fora de ordem é registrada no cabeçalho de imediato.
+    void add(std::size_t record, std::int64_t timestamp)
+    {
+        if (timestamp < max_timestamp_ && ordered_)
+        {
+            ordered_ = false;
+            write_header();
+        }
+        max_timestamp_ = std::max(max_timestamp_, timestamp);
+        if (record % interval_ == 0 && record / interval_ == entries_.size())
+        {
+            entries_.push_back(max_timestamp_);
+        }
+    }
+
+    // Grava as entradas ainda não persistidas
+    void flush()
+    {
+        if (fd_ < 0 || written_ == entries_.size())
+        {
+            return;
+        }
+        const std::size_t size = (entries_.size() - written_) * sizeof(std::int64_t);
+        const off_t offset = static_cast<off_t>(sizeof(TimeIndexHeader) + written_ * sizeof(std::int64_t));
+        if (::pwrite(fd_, entries_.data() + written_, size, offset) == static_cast<ssize_t>(size))
+        {
+            written_ = entries_.size();
+        }
+    }
+
+    // Remove todas as entradas (o log foi truncado)
+    void clear()
+    {
+        entries_.clear();
+        written_ = 0;
+        max_timestamp_ = std::numeric_limits<std::int64_t>::min();
+        if (fd_ >= 0)
+        {
+            ::ftruncate(fd_, sizeof(TimeIndexHeader));
+            if (!ordered_)
+            {
+                ordered_ = true;
+                write_header();
+            }
+        }
+    }
+
+    // Primeiro registro a examinar para encontrar leituras com timestamp >= from
+    std::size_t seek(std::int64_t from) const
+    {
+        // Até o início do último bloco cuja entrada é anterior a from, todas
+        // as leituras são anteriores a from
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), from);
+        if (it == entries_.begin())
+        {
+            return 0;
+        }
+        return static_cast<std::size_t>(it - entries_.begin() - 1) * interval_;
+    }
+
+private:
+    void write_header()
+    {
+        if (fd_ < 0)
+        {
+            return;
+        }
+        TimeIndexHeader header;
+        std::memcpy(header.magic, time_index_magic, sizeof(header.magic));
+        header.interval = static_cast<std::uint32_t>(interval_);
+        header.version = time_index_version;
+        header.flags = ordered_ ? 0 : time_index_unordered;
+        ::pwrite(fd_, &header, sizeof(header), 0);
+    }
+
+    int fd_ = -1;
+    std::size_t interval_ = 1;
+    std::vector<std::int64_t> entries_;
+    std::size_t written_ = 0; // entradas já gravadas no arquivo
+    std::int64_t max_timestamp_ = std::numeric_limits<std::int64_t>::min();
+    bool ordered_ = true;
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <string_view>
+#include "time_codec.hpp"
+
+namespace time_zone_detail
+{
+    constexpr std::int64_t offset_bias = 1 << 17; // deslocamentos cabem em ±14 h
+    constexpr std::size_t cache_slots = 1024;
+
+    // Cache do deslocamento do fuso local por hora, compartilhado por todas
+    // as threads sem locks: cada posição guarda (hora << 18) | deslocamento
+    // com viés; 0 é uma posição vazia.
+    inline std::array<std::atomic<std::uint64_t>, cache_slots> &local_offset_cache()
+    {
+        static std::array<std::atomic<std::uint64_t>, cache_slots> cache{};
+        return cache;
+    }
+
+    inline long system_offset(std::time_t at)
+    {
+        std::tm tm = {};
+        localtime_r(&at, &tm);
+        return tm.tm_gmtoff;
+    }
+
+    inline std::int64_t floor_div(std::int64_t value, std::int64_t divisor)
+    {
+        std::int64_t q = value / divisor;
+        return q - (value % divisor < 0);
+    }
+}
+
+// Fuso horário em que as datas do protocolo são lidas e escritas: o fuso
+// local do sistema (com horário de verão) ou um deslocamento fixo.
+//
+// No fuso local o deslocamento de cada hora é obtido de localtime_r uma vez
+// e guardado em um cache sem locks; as consultas seguintes não tocam o lock
+// interno da libc. Horas que contêm uma mudança de horário não são
+// guardadas e sempre consultam localtime_r.
+class TimeZone
+{
+public:
+    static TimeZone local()
+    {
+        return TimeZone(true, 0);
+    }
+
+    static TimeZone fixed(long utc_offset)
+    {
+        return TimeZone(false, utc_offset);
+    }
+
+    // Necessário apenas se o fuso do processo mudar (setenv("TZ") + tzset)
+    static void reset_local_cache()
+    {
+        for (auto &slot : time_zone_detail::local_offset_cache())
+        {
+            slot.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    bool is_local() const
+    {
+        return local_;
+    }
+
+    // Segundos a leste de UTC no instante `at`
+    long offset_at(std::time_t at) const
+    {
+        using namespace time_zone_detail;
+        if (!local_)
+        {
+            return offset_;
+        }
+
+        const std::int64_t hour = floor_div(at, 3600);
+        std::atomic<std::uint64_t> &slot = local_offset_cache()[static_cast<std::uint64_t>(hour) % cache_slots];
+        const std::uint64_t entry = slot.load(std::memory_order_relaxed);
+        if (entry != 0 && static_cast<std::int64_t>(entry >> 18) == hour)
+        {
+            return static_cast<long>(static_cast<std::int64_t>(entry & ((1u << 18) - 1)) - offset_bias);
+        }
+
+        const std::time_t start = static_cast<std::time_t>(hour * 3600);
+        const long offset = system_offset(start);
+        if (system_offset(start + 3599) != offset)
+        {
+            return system_offset(at);
+        }
+        slot.store((static_cast<std::uint64_t>(hour) << 18) | static_cast<std::uint64_t>(offset + offset_bias),
+                   std::memory_order_relaxed);
+        return offset;
+    }
+
+    // Converte uma data civil neste fuso (em segundos, como se fosse UTC)
+    // para o instante correspondente. Em horários ambíguos ou inexistentes
+    // por causa do horário de verão o resultado segue um dos deslocamentos
+    // vizinhos, como mktime.
+    std::time_t to_utc(std::time_t civil) const
+    {
+        if (!local_)
+        {
+            return civil - offset_;
+        }
+        std::time_t guess = civil - offset_at(civil);
+        return civil - offset_at(guess);
+    }
+
+    // Segundos desde a meia-noite e dias desde 1970-01-01 do instante neste fuso
+    void to_civil(std::time_t at, std::int64_t &days, long &seconds_of_day) const
+    {
+        const std::int64_t local = static_cast<std::int64_t>(at) + offset_at(at);
+        days = time_zone_detail::floor_div(local, 86400);
+        seconds_of_day = static_cast<long>(local - days * 86400);
+    }
+
+private:
+    TimeZone(bool local, long offset) : local_(local), offset_(offset) {}
+
+    bool local_;
+    long offset_;
+};
+
+// parse_iso8601 interpretando a data no fuso `zone`
+inline bool parse_iso8601(std::string_view text, std::time_t &result, const TimeZone &zone)
+{
+    std::time_t civil;
+    if (!parse_iso8601(text, civil, 0))
+    {
+        return false;
+    }
+    result = zone.to_utc(civil);
+    return true;
+}
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <sys/stat.h>
+
+// Log de escrita antecipada compartilhado por todos os sensores (modo
+// --storage=wal): as leituras recebidas são acrescentadas em sequência a um
+// único arquivo (NNNNNNNN.wal), em escritas grandes e alinhadas, em vez de
+// pequenos lotes espalhados pelos arquivos de cada sensor. O LogStore
+// compacta periodicamente o WAL nos arquivos por sensor e o descarta.
+//
+// Cada registro identifica o sensor pelo handle do catálogo e leva o número
+// da leitura no sensor (0, 1, 2, ...): ao reaplicar o WAL na inicialização,
+// leituras que já chegaram aos arquivos do sensor são ignoradas.
+//
+// As sessões apenas copiam os registros para o buffer em memória: um buffer
+// cheio é trocado pelo de reserva e entregue a uma thread de escrita do
+// WAL, que faz o pwrite (e o fdatasync) sem o mutex do buffer. A ingestão só
+// espera se o buffer anterior ainda não foi gravado.
+
+constexpr char wal_file_magic[4] = {'D', 'A', 'S', 'W'};
+
+#pragma pack(push, 1)
+struct WalFileHeader
+{
+    char magic[4];             // "DASW"
+    std::uint16_t version;     // 1
+    std::uint16_t record_size; // sizeof(WalRecord)
+    std::uint64_t reserved;
+};
+
+struct WalRecord
+{
+    std::uint32_t sensor; // handle no catálogo de sensores
+    std::uint32_t reserved;
+    std::uint64_t sequence; // número da leitura no sensor
+    std::int64_t timestamp;
+    double value;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(WalFileHeader) == 16, "WalFileHeader must be 16 bytes");
+static_assert(sizeof(WalRecord) == 32, "WalRecord must be 32 bytes");
+
+class WriteAheadLog
+{
+public:
+    static constexpr std::size_t block_size = 4096;
+
+    WriteAheadLog(bool sync_writes, std::size_t buffer_bytes = std::size_t(1) << 20)
+        : sync_writes_(sync_writes), capacity_(std::max(buffer_bytes / block_size, std::size_t(1)) * block_size)
+    {
+        buffer_.reserve(capacity_);
+        full_.reserve(capacity_);
+        writer_ = std::thread([this]
+                              { write_loop(); });
+    }
+
+    ~WriteAheadLog()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        full_cv_.notify_one();
+        writer_.join();
+        close_file(false);
+    }
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+    // Arquivos de WAL do diretório atual, em ordem de criação
+    static std::vector<std::string> existing_files()
+    {
+        std::vector<std::pair<unsigned long, std::string>> numbered;
+        std::error_code ec;
+        for (const auto &file : std::filesystem::directory_iterator(".", ec))
+        {
+            const std::filesystem::path &path = file.path();
+            const std::string stem = path.stem().string();
+            if (path.extension() != ".wal" || stem.empty() ||
+                stem.find_first_not_of("0123456789") != std::string::npos)
+            {
+                continue;
+            }
+            numbered.emplace_back(std::strtoul(stem.c_str(), nullptr, 10), path.filename().string());
+        }
+        std::sort(numbered.begin(), numbered.end());
+        std::vector<std::string> files;
+        for (auto &entry : numbered)
+        {
+            files.push_back(std::move(entry.second));
+        }
+        return files;
+    }
+
+    // Chama visit(record) para cada registro completo do arquivo. Um
+    // registro incompleto no fim (escrita interrompida) é descartado, assim
+    // como um arquivo vazio (criado pela rotação, sem nada gravado).
+    template <typename Visitor>
+    static bool replay(const std::string &path, Visitor &&visit)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            std::cerr << "Error: Could not open write-ahead log " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        WalFileHeader header;
+        const ssize_t header_size = ::pread(fd, &header, sizeof(header), 0);
+        if (header_size == 0)
+        {
+            ::close(fd);
+            return true;
+        }
+        if (header_size != static_cast<ssize_t>(sizeof(header)) ||
+            std::memcmp(header.magic, wal_file_magic, sizeof(header.magic)) != 0 || header.version != 1 ||
+            header.record_size != sizeof(WalRecord))
+        {
+            std::cerr << "Error: Unrecognized write-ahead log header in " << path << std::endl;
+            ::close(fd);
+            return false;
+        }
+
+        constexpr std::size_t chunk_records = 32768;
+        std::vector<WalRecord> chunk(chunk_records);
+        off_t offset = sizeof(header);
+        for (;;)
+        {
+            ssize_t bytes = ::pread(fd, chunk.data(), chunk_records * sizeof(WalRecord), offset);
+            if (bytes < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            const std::size_t count = bytes > 0 ? static_cast<std::size_t>(bytes) / sizeof(WalRecord) : 0;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                visit(chunk[i]);
+            }
+            if (count < chunk_records)
+            {
+                break;
+            }
+            offset += static_cast<off_t>(count * sizeof(WalRecord));
+        }
+        ::close(fd);
+        return true;
+    }
+
+    // Começa um arquivo novo, numerado após os existentes
+    bool open(unsigned long number)
+    {
+        std::lock_guard<std::mutex> io_lock(io_mutex_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        return open_file(number);
+    }
+
+    // Os registros entram inteiros no buffer: se o arquivo for trocado
+    // enquanto append espera a thread de escrita, o restante vai para o
+    // próximo arquivo sem deslocar o alinhamento dos registros.
+    void append(const WalRecord *records, std::size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const char *data = reinterpret_cast<const char *>(records);
+        std::size_t size = count * sizeof(WalRecord);
+        while (size > 0 && fd_ >= 0)
+        {
+            if (capacity_ - buffer_.size() < sizeof(WalRecord))
+            {
+                // O disco não acompanhou a ingestão: aguarda o buffer anterior
+                written_cv_.wait(lock, [this]
+                                 { return !has_full_; });
+                if (capacity_ - buffer_.size() < sizeof(WalRecord))
+                {
+                    hand_off();
+                    full_cv_.notify_one();
+                }
+                continue;
+            }
+            if (buffer_.size() == tail_size_)
+            {
+                buffer_since_ = std::chrono::steady_clock::now();
+            }
+            const std::size_t n = std::min(size, (capacity_ - buffer_.size()) / sizeof(WalRecord) * sizeof(WalRecord));
+            buffer_.insert(buffer_.end(), data, data + n);
+            data += n;
+            size -= n;
+        }
+    }
+
+    // Entrega ao kernel o buffer se ele é anterior a cutoff
+    void flush_if_older(std::chrono::steady_clock::time_point cutoff)
+    {
+        std::lock_guard<std::mutex> io_lock(io_mutex_);
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_full(lock);
+        if (fd_ >= 0 && buffer_.size() > tail_size_ && buffer_since_ <= cutoff)
+        {
+            hand_off();
+        }
+        lock.unlock();
+        write_full_buffer();
+    }
+
+    // Bytes do arquivo atual, inclusive os ainda no buffer
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return buffer_offset_ + buffer_.size();
+    }
+
+    // Fecha o arquivo atual, depois de gravar o buffer, e começa o próximo.
+    // Retorna o caminho do arquivo fechado (vazio se não havia um aberto).
+    // As leituras recebidas enquanto o arquivo anterior é gravado já vão
+    // para o próximo.
+    std::string rotate()
+    {
+        return close_file(true);
+    }
+
+    // Como rotate, sem abrir outro arquivo
+    std::string close()
+    {
+        return close_file(false);
+    }
+
+    // Torna duráveis as escritas de todos os arquivos do sistema de arquivos
+    // do diretório atual (o WAL e os arquivos dos sensores)
+    static void sync_filesystem()
+    {
+        int fd = ::open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            ::syncfs(fd);
+            ::close(fd);
+        }
+    }
+
+    static std::string path_for(unsigned long number)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%08lu.wal", number);
+        return name;
+    }
+
+private:
+    // Thread de escrita: grava os buffers cheios entregues por append
+    void write_loop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            full_cv_.wait(lock, [this]
+                          { return has_full_ || stopping_; });
+            if (stopping_)
+            {
+                return;
+            }
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> io_lock(io_mutex_);
+                write_full_buffer();
+            }
+            lock.lock();
+        }
+    }
+
+    // Deve ser chamada com mutex_ adquirido
+    bool open_file(unsigned long number)
+    {
+        number_ = number;
+        path_ = path_for(number);
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+        {
+            std::cerr << "Error: Could not open write-ahead log " << path_ << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        WalFileHeader header{};
+        std::memcpy(header.magic, wal_file_magic, sizeof(header.magic));
+        header.version = 1;
+        header.record_size = sizeof(WalRecord);
+        buffer_.assign(reinterpret_cast<const char *>(&header), reinterpret_cast<const char *>(&header) + sizeof(header));
+        buffer_offset_ = 0;
+        tail_size_ = 0;
+        buffer_since_ = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    // Grava todo o arquivo atual e o fecha; com `reopen` o próximo é aberto
+    // antes da gravação
+    std::string close_file(bool reopen)
+    {
+        std::lock_guard<std::mutex> io_lock(io_mutex_);
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::string previous = path_;
+        wait_full(lock);
+        const int fd = fd_;
+        if (fd >= 0 && buffer_.size() > tail_size_)
+        {
+            hand_off();
+        }
+        fd_ = -1;
+        path_.clear();
+        if (reopen)
+        {
+            open_file(number_ + 1);
+        }
+        lock.unlock();
+        write_full_buffer();
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        return previous;
+    }
+
+    // Deve ser chamada com io_mutex_ e mutex_ adquiridos (este em `lock`):
+    // grava o buffer cheio pendente, de modo que hand_off possa ser chamada
+    void wait_full(std::unique_lock<std::mutex> &lock)
+    {
+        while (has_full_)
+        {
+            lock.unlock();
+            write_full_buffer();
+            lock.lock();
+        }
+    }
+
+    // Deve ser chamada com mutex_ adquirido e sem buffer cheio pendente.
+    // Passa o conteúdo do buffer para full_; um bloco final incompleto é
+    // copiado de volta e regravado, completo, na próxima escrita, de modo
+    // que o buffer sempre começa em um deslocamento múltiplo de block_size.
+    void hand_off()
+    {
+        std::swap(full_, buffer_);
+        full_fd_ = fd_;
+        full_offset_ = buffer_offset_;
+        has_full_ = true;
+        const std::size_t aligned = full_.size() / block_size * block_size;
+        buffer_.assign(full_.begin() + static_cast<std::ptrdiff_t>(aligned), full_.end());
+        buffer_offset_ += aligned;
+        tail_size_ = buffer_.size();
+    }
+
+    // Deve ser chamada com io_mutex_ adquirido e mutex_ livre. Enquanto
+    // has_full_ é verdadeiro só quem tem io_mutex_ acessa full_.
+    void write_full_buffer()
+    {
+        int fd;
+        off_t offset;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!has_full_)
+            {
+                return;
+            }
+            fd = full_fd_;
+            offset = static_cast<off_t>(full_offset_);
+        }
+
+        const char *data = full_.data();
+        std::size_t size = full_.size();
+        while (size > 0)
+        {
+            ssize_t written = ::pwrite(fd, data, size, offset);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                std::cerr << "Error: Could not write write-ahead log: " << std::strerror(errno) << std::endl;
+                break;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+            offset += written;
+        }
+        if (sync_writes_)
+        {
+            ::fdatasync(fd);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            full_.clear();
+            has_full_ = false;
+        }
+        written_cv_.notify_all();
+    }
+
+    const bool sync_writes_;
+    const std::size_t capacity_; // múltiplo de block_size
+    std::mutex io_mutex_; // uma gravação de cada vez; adquirido antes de mutex_
+    mutable std::mutex mutex_;
+    std::condition_variable full_cv_;    // full_ aguarda gravação
+    std::condition_variable written_cv_; // full_ foi gravado
+    int fd_ = -1;
+    unsigned long number_ = 0;
+    std::string path_;
+    std::vector<char> buffer_;
+    std::size_t buffer_offset_ = 0; // deslocamento de buffer_[0] no arquivo
+    std::size_t tail_size_ = 0;     // bytes do buffer já gravados (bloco incompleto)
+    std::chrono::steady_clock::time_point buffer_since_;
+    std::vector<char> full_; // buffer entregue para gravação
+    bool has_full_ = false;
+    int full_fd_ = -1;
+    std::size_t full_offset_ = 0;
+    bool stopping_ = false;
+    std::thread writer_;
+};
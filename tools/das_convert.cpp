@@ -0,0 +1,114 @@
+// Converte arquivos de log de sensor entre os formatos v1 (LogRecord de 48
+// bytes) e v2 (cabeçalho + registros de 16 bytes). O id do sensor é o nome
+// do arquivo sem a extensão .log, como no servidor.
+//
+// Uso: das-convert [--to=v2|v1] <sensor.log>...
+//
+// A conversão grava um arquivo temporário e o renomeia sobre o original;
+// não execute com o servidor em funcionamento.
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "log_format.hpp"
+
+static bool convert(const std::filesystem::path &path, LogFormat target)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        std::cerr << path << ": cannot open" << std::endl;
+        return false;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    LogLayout source;
+    if (!detect_log_layout(data.data(), data.size(), data.size(), source))
+    {
+        std::cerr << path << ": unrecognized log file header" << std::endl;
+        return false;
+    }
+    if (source.format == target)
+    {
+        std::cout << path.string() << ": already v" << static_cast<int>(target) << std::endl;
+        return true;
+    }
+
+    const std::string sensor_id = path.stem().string();
+    const LogLayout layout = LogLayout::for_format(target);
+    const std::size_t count = source.record_count(data.size());
+
+    std::vector<char> output;
+    output.reserve(layout.data_offset + count * layout.record_size);
+    if (target == LogFormat::v2)
+    {
+        LogFileHeader header = make_log_header(sensor_id);
+        const char *bytes = reinterpret_cast<const char *>(&header);
+        output.insert(output.end(), bytes, bytes + sizeof(header));
+    }
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        layout.encode(sensor_id, source.decode(data.data(), i), output);
+    }
+
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(output.data(), static_cast<std::streamsize>(output.size()));
+        if (!out.flush())
+        {
+            std::cerr << tmp << ": write failed" << std::endl;
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp, path);
+
+    std::cout << path.string() << ": " << count << " records, v" << static_cast<int>(source.format)
+              << " -> v" << static_cast<int>(target) << " (" << data.size() << " -> " << output.size() << " bytes)"
+              << std::endl;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    LogFormat target = LogFormat::v2;
+    std::vector<std::filesystem::path> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--to=v2")
+            target = LogFormat::v2;
+        else if (arg == "--to=v1")
+            target = LogFormat::v1;
+        else
+            files.emplace_back(arg);
+    }
+
+    if (files.empty())
+    {
+        std::cerr << "Usage: das-convert [--to=v2|v1] <sensor.log>...\n";
+        return 1;
+    }
+
+    bool ok = true;
+    for (const auto &file : files)
+    {
+        try
+        {
+            ok &= convert(file, target);
+        }
+        catch (const std::filesystem::filesystem_error &e)
+        {
+            std::cerr << e.what() << std::endl;
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}